@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <ios>
 #include <iterator>
@@ -85,6 +86,70 @@ bool compareFiles(const std::string& file1, const std::string& file2)
       std::istreambuf_iterator<char>(f2.rdbuf()));
 }
 
+// Reads a binary PPM image with 8-bit components, as written by
+// writePpmFile().
+static bool readPpmFile(
+    const std::string& file,
+    unsigned& width,
+    unsigned& height,
+    std::vector<unsigned char>& pixels)
+{
+  std::ifstream ifs(file, std::ifstream::binary);
+
+  std::string magic;
+  unsigned maxValue = 0;
+  ifs >> magic >> width >> height >> maxValue;
+  if(ifs.fail() || magic != "P6" || maxValue != 255) {
+    return false;
+  }
+  ifs.get();  // The whitespace ending the header.
+
+  pixels.resize(size_t(width) * height * 3);
+  ifs.read(
+      reinterpret_cast<char*>(pixels.data()),
+      static_cast<std::streamsize>(pixels.size()));
+  return !ifs.fail();
+}
+
+bool comparePpmFiles(
+    const std::string& file1,
+    const std::string& file2,
+    int tolerance,
+    int& maxDifference,
+    size_t& differentPixels)
+{
+  unsigned width1 = 0;
+  unsigned height1 = 0;
+  unsigned width2 = 0;
+  unsigned height2 = 0;
+  std::vector<unsigned char> pixels1;
+  std::vector<unsigned char> pixels2;
+
+  if(!readPpmFile(file1, width1, height1, pixels1)
+     || !readPpmFile(file2, width2, height2, pixels2)) {
+    return false;  // File problem.
+  }
+
+  if(width1 != width2 || height1 != height2 || pixels1.empty()) {
+    return false;  // Size mismatch.
+  }
+
+  maxDifference = 0;
+  differentPixels = 0;
+  for(size_t i = 0; i < pixels1.size(); i += 3) {
+    int pixelDifference = 0;
+    for(size_t c = i; c < i + 3; ++c) {
+      pixelDifference = std::max(
+          pixelDifference, std::abs(int(pixels1[c]) - int(pixels2[c])));
+    }
+    maxDifference = std::max(maxDifference, pixelDifference);
+    if(pixelDifference > tolerance) {
+      ++differentPixels;
+    }
+  }
+  return true;
+}
+
 // https://stackoverflow.com/a/525103
 // https://stackoverflow.com/a/43009155
 std::string readFile(const std::string& file)
@@ -24,6 +24,7 @@
 #ifndef FILEUTIL_H
 #define FILEUTIL_H
 
+#include <cstddef>
 #include <string>
 
 bool writePpmFile(
@@ -35,6 +36,16 @@ bool writePpmFile(
 
 bool compareFiles(const std::string& file1, const std::string& file2);
 
+// Compares two binary PPM images of the same size, 'maxDifference' receives
+// the largest difference of their colour components and 'differentPixels'
+// the number of pixels with a component differing by more than 'tolerance'.
+bool comparePpmFiles(
+    const std::string& file1,
+    const std::string& file2,
+    int tolerance,
+    int& maxDifference,
+    size_t& differentPixels);
+
 std::string readFile(const std::string& file);
 
 #endif  // FILEUTIL_H
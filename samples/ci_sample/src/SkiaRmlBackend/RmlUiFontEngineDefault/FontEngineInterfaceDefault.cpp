@@ -99,4 +99,9 @@ void FontEngineInterfaceDefault::ReleaseFontResources()
 	FontProvider::ReleaseFontResources();
 }
 
+void FontEngineInterfaceDefault::SetTextureAllocator(FontTextureAllocator* allocator)
+{
+	FontProvider::SetTextureAllocator(allocator);
+}
+
 } // namespace Rml
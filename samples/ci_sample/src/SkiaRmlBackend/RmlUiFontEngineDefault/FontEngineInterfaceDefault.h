@@ -32,6 +32,8 @@
 
 namespace Rml {
 
+class FontTextureAllocator;
+
 class RMLUICORE_API FontEngineInterfaceDefault : public FontEngineInterface {
 public:
 	/// Called when RmlUi is being initialized.
@@ -71,6 +73,10 @@ public:
 
 	/// Releases resources owned by sized font faces, including their textures and rendered glyphs.
 	void ReleaseFontResources() override;
+
+	/// Sets the allocator of the memory the font textures are generated in, or nullptr to allocate it in the font engine. The
+	/// allocator is not owned and must outlive its use by RmlUi or be reset.
+	void SetTextureAllocator(FontTextureAllocator* allocator);
 };
 
 } // namespace Rml
@@ -173,8 +173,8 @@ int FontFaceHandleDefault::GenerateLayerConfiguration(const FontEffectList& font
 	return (int)(layer_configurations.size() - 1);
 }
 
-bool FontFaceHandleDefault::GenerateLayerTexture(Vector<byte>& texture_data, Vector2i& texture_dimensions, const FontEffect* font_effect,
-	int texture_id, int handle_version) const
+bool FontFaceHandleDefault::GenerateLayerTexture(Vector<byte>& texture_storage, Span<byte>& texture_data, Vector2i& texture_dimensions,
+	const FontEffect* font_effect, int texture_id, int handle_version) const
 {
 	if (handle_version != version)
 	{
@@ -190,7 +190,7 @@ bool FontFaceHandleDefault::GenerateLayerTexture(Vector<byte>& texture_data, Vec
 		return false;
 	}
 
-	return it->layer->GenerateTexture(texture_data, texture_dimensions, texture_id, glyphs);
+	return it->layer->GenerateTexture(texture_storage, texture_data, texture_dimensions, texture_id, glyphs);
 }
 
 int FontFaceHandleDefault::GenerateString(RenderManager& render_manager, TexturedMeshList& mesh_list, StringView string, const Vector2f position,
@@ -68,13 +68,14 @@ public:
 	/// @return The index to use when generating geometry using this configuration.
 	int GenerateLayerConfiguration(const FontEffectList& font_effects);
 	/// Generates the texture data for a layer (for the texture database).
-	/// @param[out] texture_data The generated texture data.
+	/// @param[out] texture_storage The memory of the texture data, if it is not allocated by the texture allocator.
+	/// @param[out] texture_data The generated texture data, in memory of the texture allocator or in texture_storage.
 	/// @param[out] texture_dimensions The dimensions of the texture.
 	/// @param[in] font_effect The font effect used for the layer.
 	/// @param[in] texture_id The index of the texture within the layer to generate.
 	/// @param[in] handle_version The version of the handle data. Function returns false if out of date.
-	bool GenerateLayerTexture(Vector<byte>& texture_data, Vector2i& texture_dimensions, const FontEffect* font_effect, int texture_id,
-		int handle_version) const;
+	bool GenerateLayerTexture(Vector<byte>& texture_storage, Span<byte>& texture_data, Vector2i& texture_dimensions,
+		const FontEffect* font_effect, int texture_id, int handle_version) const;
 
 	/// Generates the geometry required to render a single line of text.
 	/// @param[in] render_manager The render manager responsible for rendering the string.
@@ -29,6 +29,9 @@
 #include "FontFaceLayer.h"
 #include "RmlUi/Core/RenderManager.h"
 #include "FontFaceHandleDefault.h"
+#include "FontProvider.h"
+#include "FontTextureAllocator.h"
+#include <algorithm>
 #include <string.h>
 #include <type_traits>
 
@@ -163,12 +166,15 @@ bool FontFaceLayer::Generate(const FontFaceHandleDefault* handle, const FontFace
 			CallbackTextureFunction texture_callback = [handle, effect_ptr, texture_id, handle_version](
 														   const CallbackTextureInterface& texture_interface) -> bool {
 				Vector2i dimensions;
-				Vector<byte> data;
-				if (!handle->GenerateLayerTexture(data, dimensions, effect_ptr, texture_id, handle_version) || data.empty())
-					return false;
-				if (!texture_interface.GenerateTexture(data, dimensions))
-					return false;
-				return true;
+				Vector<byte> storage;
+				Span<byte> data;
+				const bool result = handle->GenerateLayerTexture(storage, data, dimensions, effect_ptr, texture_id, handle_version) &&
+					!data.empty() && texture_interface.GenerateTexture(Span<const byte>(data.data(), data.size()), dimensions);
+
+				// The render interface may have taken the memory of the allocator as the texture pixels, else it copied them.
+				if (!data.empty() && data.data() != storage.data())
+					FontProvider::GetTextureAllocator()->ReleaseTexture(data);
+				return result;
 			};
 
 			static_assert(std::is_nothrow_move_constructible<CallbackTextureSource>::value,
@@ -181,35 +187,102 @@ bool FontFaceLayer::Generate(const FontFaceHandleDefault* handle, const FontFace
 	return true;
 }
 
-bool FontFaceLayer::GenerateTexture(Vector<byte>& texture_data, Vector2i& texture_dimensions, int texture_id, const FontGlyphMap& glyphs)
+// Zeroes the texture data outside of the rectangles, which do not overlap, row by row.
+static void ClearTexturePadding(Span<byte> texture_data, Vector2i texture_dimensions, Vector<TextureLayoutRectangle*>& rectangles)
+{
+	std::sort(rectangles.begin(), rectangles.end(),
+		[](TextureLayoutRectangle* a, TextureLayoutRectangle* b) { return a->GetPosition().x < b->GetPosition().x; });
+
+	const int texture_stride = texture_dimensions.x * 4;
+	for (int y = 0; y < texture_dimensions.y; ++y)
+	{
+		byte* row = texture_data.data() + y * texture_stride;
+		int x = 0;
+
+		for (TextureLayoutRectangle* rectangle : rectangles)
+		{
+			const Vector2i position = rectangle->GetPosition();
+			const Vector2i dimensions = rectangle->GetDimensions();
+			if (y < position.y || y >= position.y + dimensions.y)
+				continue;
+
+			memset(row + x * 4, 0, (position.x - x) * 4);
+			x = position.x + dimensions.x;
+		}
+
+		memset(row + x * 4, 0, (texture_dimensions.x - x) * 4);
+	}
+}
+
+// Zeroes the texture data of a rectangle.
+static void ClearRectangle(TextureLayoutRectangle& rectangle)
+{
+	byte* destination = rectangle.GetTextureData();
+	for (int y = 0; y < rectangle.GetDimensions().y; ++y)
+	{
+		memset(destination, 0, rectangle.GetDimensions().x * 4);
+		destination += rectangle.GetTextureStride();
+	}
+}
+
+bool FontFaceLayer::GenerateTexture(Vector<byte>& texture_storage, Span<byte>& texture_data, Vector2i& texture_dimensions, int texture_id,
+	const FontGlyphMap& glyphs)
 {
 	if (texture_id < 0 || texture_id > texture_layout.GetNumTextures())
 		return false;
 
-	// Generate the texture data.
-	texture_data = texture_layout.GetTexture(texture_id).AllocateTexture();
 	texture_dimensions = texture_layout.GetTexture(texture_id).GetDimensions();
+	if (texture_dimensions.x <= 0 || texture_dimensions.y <= 0)
+		return false;
+
+	// Generate the texture data in memory of the texture allocator, which the render interface may take as the texture pixels. The
+	// memory is uninitialised, so the padding between the glyph rectangles is zeroed, and the rectangles as far as the glyphs do not
+	// fill them.
+	const int texture_stride = texture_dimensions.x * 4;
+	const size_t texture_size = size_t(texture_stride) * size_t(texture_dimensions.y);
+	FontTextureAllocator* allocator = FontProvider::GetTextureAllocator();
+	texture_data = allocator ? allocator->AllocateTexture(texture_dimensions) : Span<byte>();
+	if (texture_data.empty())
+	{
+		texture_storage.resize(texture_size);
+		texture_data = Span<byte>(texture_storage.data(), texture_storage.size());
+	}
+	RMLUI_ASSERT(texture_data.size() == texture_size);
 
+	Vector<TextureLayoutRectangle*> texture_rectangles;
 	for (int i = 0; i < texture_layout.GetNumRectangles(); ++i)
 	{
 		TextureLayoutRectangle& rectangle = texture_layout.GetRectangle(i);
+		if (rectangle.GetTextureIndex() != texture_id)
+			continue;
+
+		const Vector2i position = rectangle.GetPosition();
+		rectangle.Allocate(texture_data.data() + position.y * texture_stride + position.x * 4, texture_stride);
+		texture_rectangles.push_back(&rectangle);
+	}
+
+	ClearTexturePadding(texture_data, texture_dimensions, texture_rectangles);
+
+	for (TextureLayoutRectangle* texture_rectangle : texture_rectangles)
+	{
+		TextureLayoutRectangle& rectangle = *texture_rectangle;
 		Character character = (Character)rectangle.GetId();
 		RMLUI_ASSERT(character_boxes.find(character) != character_boxes.end());
 
 		TextureBox& box = character_boxes[character];
 
-		if (box.texture_index != texture_id)
-			continue;
-
 		auto it = glyphs.find((Character)rectangle.GetId());
 		if (it == glyphs.end())
+		{
+			ClearRectangle(rectangle);
 			continue;
+		}
 
 		const FontGlyph& glyph = it->second;
 
 		if (effect == nullptr)
 		{
-			// Copy the glyph's bitmap data into its allocated texture.
+			// Copy the glyph's bitmap data into its allocated texture, the bitmap fills the rectangle.
 			if (glyph.bitmap_data)
 			{
 				byte* destination = rectangle.GetTextureData();
@@ -239,9 +312,13 @@ bool FontFaceLayer::GenerateTexture(Vector<byte>& texture_data, Vector2i& textur
 					source += num_bytes_per_line;
 				}
 			}
+			else
+				ClearRectangle(rectangle);
 		}
 		else
 		{
+			// Font effects may write only some of the pixels of the rectangle.
+			ClearRectangle(rectangle);
 			effect->GenerateGlyphTexture(rectangle.GetTextureData(), Vector2i(box.dimensions), rectangle.GetTextureStride(), glyph);
 		}
 	}
@@ -60,11 +60,13 @@ public:
 	bool Generate(const FontFaceHandleDefault* handle, const FontFaceLayer* clone = nullptr, bool clone_glyph_origins = false);
 
 	/// Generates the texture data for a layer (for the texture database).
-	/// @param[out] texture_data The generated texture data.
+	/// @param[out] texture_storage The memory of the texture data, if it is not allocated by the texture allocator.
+	/// @param[out] texture_data The generated texture data, in memory of the texture allocator or in texture_storage.
 	/// @param[out] texture_dimensions The dimensions of the texture.
 	/// @param[in] texture_id The index of the texture within the layer to generate.
 	/// @param[in] glyphs The glyphs required by the font face handle.
-	bool GenerateTexture(Vector<byte>& texture_data, Vector2i& texture_dimensions, int texture_id, const FontGlyphMap& glyphs);
+	bool GenerateTexture(Vector<byte>& texture_storage, Span<byte>& texture_data, Vector2i& texture_dimensions, int texture_id,
+		const FontGlyphMap& glyphs);
 
 	/// Generates the geometry required to render a single character.
 	/// @param[out] mesh_list An array of meshes this layer will write to. It must be at least as big as the number of textures in this layer.
@@ -42,6 +42,7 @@ namespace Rml {
 static String GetFontFaceDescription(const String& font_family, Style::FontStyle style, Style::FontWeight weight);
 
 static FontProvider* g_font_provider = nullptr;
+static FontTextureAllocator* g_texture_allocator = nullptr;
 
 FontProvider::FontProvider()
 {
@@ -111,6 +112,16 @@ void FontProvider::ReleaseFontResources()
 		name_family.second->ReleaseFontResources();
 }
 
+void FontProvider::SetTextureAllocator(FontTextureAllocator* allocator)
+{
+	g_texture_allocator = allocator;
+}
+
+FontTextureAllocator* FontProvider::GetTextureAllocator()
+{
+	return g_texture_allocator;
+}
+
 bool FontProvider::LoadFontFace(const String& file_name, int face_index, bool fallback_face, Style::FontWeight weight)
 {
 	FileInterface* file_interface = GetFileInterface();
@@ -38,6 +38,7 @@ namespace Rml {
 class FontFace;
 class FontFamily;
 class FontFaceHandleDefault;
+class FontTextureAllocator;
 
 /**
     The font provider contains all font families currently in use by RmlUi.
@@ -74,6 +75,11 @@ public:
 	/// Releases resources owned by sized font faces, including their textures and rendered glyphs.
 	static void ReleaseFontResources();
 
+	/// Sets the allocator of the texture memory, or nullptr to allocate it in the font engine. Kept over initialisation.
+	static void SetTextureAllocator(FontTextureAllocator* allocator);
+	/// Returns the allocator of the texture memory, or nullptr if there is none.
+	static FontTextureAllocator* GetTextureAllocator();
+
 private:
 	FontProvider();
 	~FontProvider();
@@ -0,0 +1,56 @@
+/*
+ * This source file is part of RmlUi, the HTML/CSS Interface Middleware
+ *
+ * For the latest information, see http://github.com/mikke89/RmlUi
+ *
+ * Copyright (c) 2008-2010 CodePoint Ltd, Shift Technology Ltd
+ * Copyright (c) 2019-2023 The RmlUi Team, and contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef RMLUI_CORE_FONTENGINEDEFAULT_FONTTEXTUREALLOCATOR_H
+#define RMLUI_CORE_FONTENGINEDEFAULT_FONTTEXTUREALLOCATOR_H
+
+#include "RmlUi/Core/Types.h"
+
+namespace Rml {
+
+/**
+    Allocates the memory the font engine generates its textures in, so that a render interface can take that memory as the texture
+    pixels in GenerateTexture() instead of copying them. Set with FontEngineInterfaceDefault::SetTextureAllocator().
+ */
+
+class FontTextureAllocator {
+public:
+	virtual ~FontTextureAllocator() {}
+
+	/// Allocates memory for the pixels of a texture.
+	/// @param[in] dimensions The dimensions of the texture.
+	/// @return Uninitialised memory for the 32-bit RGBA pixels, or an empty span to let the font engine allocate the memory itself.
+	virtual Span<byte> AllocateTexture(Vector2i dimensions) = 0;
+
+	/// Releases memory returned by AllocateTexture(), once the texture was generated from it or its generation failed.
+	/// @param[in] data The memory returned by AllocateTexture().
+	virtual void ReleaseTexture(Span<byte> data) = 0;
+};
+
+} // namespace Rml
+#endif
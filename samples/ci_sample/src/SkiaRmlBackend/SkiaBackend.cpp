@@ -30,6 +30,7 @@
 
 #include "RmlUiFontEngineDefault/FontEngineInterfaceDefault.h"
 #include "SkiaBackend.h"
+#include "SkiaPresentThread.h"
 #include "SkiaRenderInterface.h"
 #include "SkiaSystemInterface.h"
 
@@ -38,8 +39,392 @@
 #include <RmlUi/Core/Log.h>
 
 #include "include/core/SkCanvas.h"
+#include "include/core/SkPixmap.h"
 #include "include/core/SkSurface.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Longest wait for events in power save mode.
+static constexpr double MAX_EVENT_WAIT = 10.0;
+
+// Pixel memory of a surface owned by an instance, kept over resizes.
+struct PixelStorage
+{
+  Rml::UniquePtr<Rml::byte[]> pixels;
+  size_t capacity = 0;
+};
+
+// Makes a surface on the memory of 'storage', growing it if the surface does
+// not fit. The memory is only replaced once the new one is allocated.
+static sk_sp<SkSurface> MakeStorageSurface(
+    PixelStorage& storage, const SkImageInfo& image_info)
+{
+  const size_t byteSize = image_info.computeMinByteSize();
+
+  if(byteSize > storage.capacity) {
+    // Grows geometrically, so a window dragged larger reallocates only a few
+    // times.
+    const size_t capacity =
+        std::max(byteSize, storage.capacity + storage.capacity / 2);
+    auto* pixels = new(std::nothrow) Rml::byte[capacity];
+    if(!pixels) {
+      return nullptr;
+    }
+    storage.pixels.reset(pixels);
+    storage.capacity = capacity;
+  }
+
+  return SkSurface::MakeRasterDirect(
+      image_info, storage.pixels.get(), image_info.minRowBytes());
+}
+
+struct SkiaBackend::Instance::Data
+{
+  Data(sk_sp<SkSurface> surface, SkCanvas* canvas)
+      : surface_ {std::move(surface)}
+      , canvas_ {canvas}
+      , render_interface {canvas, canvas->imageInfo().colorType()}
+  {
+  }
+
+  void SetSurface(sk_sp<SkSurface> surface)
+  {
+    surface_ = std::move(surface);
+    canvas_ = surface_->getCanvas();
+    render_interface.SetCanvas(canvas_);
+  }
+
+  // The surface holding the last finished frame.
+  SkSurface* GetFinishedSurface()
+  {
+    return finished_buffer >= 0 ? buffers[finished_buffer].get()
+                                : surface_.get();
+  }
+
+  // The memory of the surface, or of every buffer of the ring. Empty for
+  // caller memory.
+  Rml::Vector<PixelStorage> storage;
+
+  sk_sp<SkSurface> surface_;
+  SkCanvas* canvas_ = nullptr;
+  SkiaRenderInterface render_interface;
+  bool caller_pixels = false;
+  uint64_t finished_frame = 0;
+
+  // The surface ring of the present thread, 'surface_' is the buffer rendered
+  // to. The pixmaps are taken on the render thread for the present thread.
+  Rml::Vector<sk_sp<SkSurface>> buffers;
+  Rml::Vector<SkPixmap> buffer_pixmaps;
+  int buffer_index = 0;
+  int finished_buffer = -1;
+  PresentCallback present_callback;
+  // Declared last, the thread stops before the buffers are released.
+  Rml::UniquePtr<SkiaPresentThread> present_thread;
+};
+
+static SkImageInfo MakeSurfaceInfo(
+    int width, int height, SkColorType color_type)
+{
+  SkAlphaType alphaType = SkAlphaType::kOpaque_SkAlphaType;
+
+  return SkImageInfo::Make(width, height, color_type, alphaType);
+}
+
+Rml::UniquePtr<SkiaBackend::Instance> SkiaBackend::Instance::Create(
+    int width, int height, SkColorType color_type)
+{
+  PixelStorage storage;
+  sk_sp<SkSurface> surface = MakeStorageSurface(
+      storage, MakeSurfaceInfo(width, height, color_type));
+  if(!surface) {
+    return nullptr;
+  }
+
+  SkCanvas* canvas = surface->getCanvas();
+  if(!canvas) {
+    return nullptr;
+  }
+
+  auto instanceData = Rml::MakeUnique<Data>(std::move(surface), canvas);
+  instanceData->storage.push_back(std::move(storage));
+  return Rml::UniquePtr<Instance>(new Instance(std::move(instanceData)));
+}
+
+Rml::UniquePtr<SkiaBackend::Instance> SkiaBackend::Instance::CreateDirect(
+    int width,
+    int height,
+    void* pixels,
+    size_t row_bytes,
+    SkColorType color_type)
+{
+  SkImageInfo imageInfo = MakeSurfaceInfo(width, height, color_type);
+
+  if(!pixels || row_bytes < imageInfo.minRowBytes()) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR,
+        "Skia surface pixels are missing or the row stride is too short.");
+    return nullptr;
+  }
+
+  sk_sp<SkSurface> surface =
+      SkSurface::MakeRasterDirect(imageInfo, pixels, row_bytes);
+  if(!surface) {
+    return nullptr;
+  }
+
+  SkCanvas* canvas = surface->getCanvas();
+  if(!canvas) {
+    return nullptr;
+  }
+
+  auto instanceData = Rml::MakeUnique<Data>(std::move(surface), canvas);
+  instanceData->caller_pixels = true;
+  return Rml::UniquePtr<Instance>(new Instance(std::move(instanceData)));
+}
+
+SkiaBackend::Instance::Instance(Rml::UniquePtr<Data> data)
+    : data {std::move(data)}
+{
+}
+
+SkiaBackend::Instance::~Instance() = default;
+
+SkSurface* SkiaBackend::Instance::GetSurface()
+{
+  return data->surface_.get();
+}
+
+SkCanvas* SkiaBackend::Instance::GetCanvas()
+{
+  return data->canvas_;
+}
+
+Rml::Span<const Rml::byte> SkiaBackend::Instance::GetPixels()
+{
+  SkPixmap pixmap;
+  if(!data->GetFinishedSurface()->peekPixels(&pixmap)) {
+    return {};
+  }
+
+  return {
+      static_cast<const Rml::byte*>(pixmap.addr()), pixmap.computeByteSize()};
+}
+
+size_t SkiaBackend::Instance::GetRowBytes()
+{
+  SkPixmap pixmap;
+  return data->GetFinishedSurface()->peekPixels(&pixmap) ? pixmap.rowBytes()
+                                                         : 0;
+}
+
+SkColorType SkiaBackend::Instance::GetColorType()
+{
+  return data->surface_->imageInfo().colorType();
+}
+
+SkiaRenderInterface* SkiaBackend::Instance::GetRenderInterface()
+{
+  return &data->render_interface;
+}
+
+void SkiaBackend::Instance::BeginFrame()
+{
+  data->render_interface.BeginFrame();
+}
+
+const Rml::Vector<Rml::Rectanglei>& SkiaBackend::Instance::PresentFrame()
+{
+  data->render_interface.EndFrame();
+  const uint64_t frame = ++data->finished_frame;
+
+  if(data->present_thread) {
+    const int bufferCount = static_cast<int>(data->buffers.size());
+
+    data->finished_buffer = data->buffer_index;
+    data->present_thread->Submit(frame, data->buffer_index);
+
+    // The next buffer holds the frame 'bufferCount' - 1 frames before this
+    // one, it is free when that frame is presented.
+    data->buffer_index = (data->buffer_index + 1) % bufferCount;
+    if(frame >= static_cast<uint64_t>(bufferCount)) {
+      data->present_thread->WaitForFrame(frame + 1 - bufferCount);
+    }
+    data->SetSurface(data->buffers[data->buffer_index]);
+  }
+
+  return data->render_interface.GetDamageRects();
+}
+
+bool SkiaBackend::Instance::StartPresentThread(
+    int buffer_count, PresentCallback callback)
+{
+  if(data->caller_pixels || buffer_count < 2 || !callback) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR,
+        "Skia present thread needs at least 2 buffers, a callback and an "
+        "instance owning its pixels.");
+    return false;
+  }
+
+  StopPresentThread();
+
+  // The current surface is the first buffer.
+  const SkImageInfo imageInfo = data->surface_->imageInfo();
+  data->storage.resize(buffer_count);
+  data->buffers.push_back(data->surface_);
+  for(int i = 1; i < buffer_count; ++i) {
+    sk_sp<SkSurface> surface =
+        MakeStorageSurface(data->storage[i], imageInfo);
+    if(!surface) {
+      data->buffers.clear();
+      data->storage.resize(1);
+      return false;
+    }
+    data->buffers.push_back(std::move(surface));
+  }
+
+  if(!TakeBufferPixmaps()) {
+    data->buffers.clear();
+    data->storage.resize(1);
+    return false;
+  }
+
+  data->buffer_index = 0;
+  data->finished_buffer = -1;
+  data->present_callback = std::move(callback);
+
+  Data* instanceData = data.get();
+  data->present_thread = Rml::MakeUnique<SkiaPresentThread>(
+      buffer_count, data->finished_frame,
+      [instanceData](uint64_t frame, int buffer) {
+        const SkPixmap& pixmap = instanceData->buffer_pixmaps[buffer];
+
+        Frame presented;
+        presented.index = frame;
+        presented.pixels = {
+            static_cast<const Rml::byte*>(pixmap.addr()),
+            pixmap.computeByteSize()};
+        presented.row_bytes = pixmap.rowBytes();
+        presented.width = pixmap.width();
+        presented.height = pixmap.height();
+        presented.color_type = pixmap.colorType();
+
+        instanceData->present_callback(presented);
+      });
+
+  return true;
+}
+
+void SkiaBackend::Instance::StopPresentThread()
+{
+  if(!data->present_thread) {
+    return;
+  }
+
+  data->present_thread.reset();
+
+  if(data->finished_buffer >= 0) {
+    // The buffer of the last frame keeps being rendered to.
+    std::swap(data->storage[0], data->storage[data->finished_buffer]);
+    data->SetSurface(data->buffers[data->finished_buffer]);
+  }
+
+  data->buffers.clear();
+  data->storage.resize(1);
+  data->buffer_pixmaps.clear();
+  data->buffer_index = 0;
+  data->finished_buffer = -1;
+  data->present_callback = nullptr;
+}
+
+bool SkiaBackend::Instance::TakeBufferPixmaps()
+{
+  data->buffer_pixmaps.resize(data->buffers.size());
+  for(size_t i = 0; i < data->buffers.size(); ++i) {
+    if(!data->buffers[i]->peekPixels(&data->buffer_pixmaps[i])) {
+      data->buffer_pixmaps.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SkiaBackend::Instance::Resize(int width, int height)
+{
+  if(data->caller_pixels) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR,
+        "Skia surface rendering into caller memory can not be resized.");
+    return false;
+  }
+
+  if(width <= 0 || height <= 0) {
+    return false;
+  }
+
+  const SkImageInfo oldInfo = data->surface_->imageInfo();
+  const SkImageInfo imageInfo = oldInfo.makeWH(width, height);
+  if(imageInfo.dimensions() == oldInfo.dimensions()) {
+    return true;
+  }
+
+  if(!data->present_thread) {
+    sk_sp<SkSurface> surface =
+        MakeStorageSurface(data->storage[0], imageInfo);
+    if(!surface) {
+      return false;
+    }
+    data->SetSurface(std::move(surface));
+    return true;
+  }
+
+  // The present thread must be done with every buffer.
+  data->present_thread->WaitForFrame(data->finished_frame);
+
+  bool resized = true;
+  for(size_t i = 0; i < data->buffers.size(); ++i) {
+    sk_sp<SkSurface> surface =
+        MakeStorageSurface(data->storage[i], imageInfo);
+    if(!surface) {
+      // The buffers resized so far go back to the old size, their memory
+      // fits it.
+      for(size_t j = 0; j < i; ++j) {
+        data->buffers[j] = MakeStorageSurface(data->storage[j], oldInfo);
+      }
+      resized = false;
+      break;
+    }
+    data->buffers[i] = std::move(surface);
+  }
+
+  data->SetSurface(data->buffers[data->buffer_index]);
+  return TakeBufferPixmaps() && resized;
+}
+
+uint64_t SkiaBackend::Instance::GetFinishedFrame()
+{
+  return data->finished_frame;
+}
+
+uint64_t SkiaBackend::Instance::GetPresentedFrame()
+{
+  return data->present_thread ? data->present_thread->GetPresentedFrame()
+                              : data->finished_frame;
+}
+
+void SkiaBackend::Instance::WaitForFrame(uint64_t frame)
+{
+  if(data->present_thread) {
+    data->present_thread->WaitForFrame(frame);
+  }
+}
+
 /**
     Global data used by this backend.
 
@@ -48,46 +433,88 @@
  */
 struct SkiaBackendData
 {
-  SkiaBackendData(sk_sp<SkSurface> surface, SkCanvas* canvas)
-      : surface_ {std::move(surface)}
-      , canvas_ {canvas}
-      , render_interface {canvas}
+  explicit SkiaBackendData(Rml::UniquePtr<SkiaBackend::Instance> instance)
+      : instance {std::move(instance)}
   {
+    // The font engine generates its textures in memory which the render
+    // interface takes as the texture pixels.
+    font_engine_interface.SetTextureAllocator(&texture_memory);
+    this->instance->GetRenderInterface()->SetTextureMemory(&texture_memory);
+  }
+
+  ~SkiaBackendData()
+  {
+    font_engine_interface.SetTextureAllocator(nullptr);
   }
 
-  sk_sp<SkSurface> surface_;
-  SkCanvas* canvas_ = nullptr;
   bool running = true;
+  bool allow_resize = false;
+
+  // The frame loop: the next frame renders if an update is pending, or once
+  // the delay requested by the context since the last update passed.
+  std::atomic<SkiaBackend::EventSource*> event_source {nullptr};
+  std::atomic<bool> update_pending {true};
+  // Ends the wait of a loop without an event source when a frame is
+  // requested.
+  std::mutex request_mutex;
+  std::condition_variable request_condition;
+  double last_update_time = 0;
+  SkiaBackend::ScheduleStats schedule_stats;
 
   SkiaSystemInterface system_interface;
+  SkiaTextureMemory texture_memory;
   Rml::FontEngineInterfaceDefault font_engine_interface;
-  SkiaRenderInterface render_interface;
+  Rml::UniquePtr<SkiaBackend::Instance> instance;
 };
 
 static Rml::UniquePtr<SkiaBackendData> data;
 
+// The update delays of the context count on the clock of the installed
+// system interface.
+static double GetElapsedTime()
+{
+  Rml::SystemInterface* systemInterface = Rml::GetSystemInterface();
+  return systemInterface ? systemInterface->GetElapsedTime()
+                         : data->system_interface.GetElapsedTime();
+}
+
 bool SkiaBackend::Initialize(
-    const char* /*window_name*/, int width, int height, bool /*allow_resize*/)
+    const char* /*window_name*/,
+    int width,
+    int height,
+    bool allow_resize,
+    SkColorType color_type)
 {
   RMLUI_ASSERT(!data);
 
-  SkColorType colorType = SkColorType::kRGBA_8888_SkColorType;
-  SkAlphaType alphaType = SkAlphaType::kOpaque_SkAlphaType;
-
-  SkImageInfo imageInfo =
-      SkImageInfo::Make(width, height, colorType, alphaType);
-
-  sk_sp<SkSurface> surface = SkSurface::MakeRaster(imageInfo);
-  if(!surface) {
+  Rml::UniquePtr<Instance> instance =
+      Instance::Create(width, height, color_type);
+  if(!instance) {
     return false;
   }
 
-  SkCanvas* canvas = surface->getCanvas();
-  if(!canvas) {
+  data = Rml::MakeUnique<SkiaBackendData>(std::move(instance));
+  data->allow_resize = allow_resize;
+  return true;
+}
+
+bool SkiaBackend::Initialize(
+    const char* /*window_name*/,
+    int width,
+    int height,
+    void* pixels,
+    size_t row_bytes,
+    SkColorType color_type)
+{
+  RMLUI_ASSERT(!data);
+
+  Rml::UniquePtr<Instance> instance =
+      Instance::CreateDirect(width, height, pixels, row_bytes, color_type);
+  if(!instance) {
     return false;
   }
 
-  data = Rml::MakeUnique<SkiaBackendData>(surface, canvas);
+  data = Rml::MakeUnique<SkiaBackendData>(std::move(instance));
   return true;
 }
 
@@ -97,6 +524,20 @@ void SkiaBackend::Shutdown()
   data.reset();
 }
 
+bool SkiaBackend::Resize(int width, int height)
+{
+  RMLUI_ASSERT(data);
+
+  if(!data->allow_resize) {
+    Rml::Log::Message(
+        Rml::Log::LT_WARNING,
+        "Skia backend was initialized without allow_resize.");
+    return false;
+  }
+
+  return data->instance->Resize(width, height);
+}
+
 Rml::SystemInterface* SkiaBackend::GetSystemInterface()
 {
   RMLUI_ASSERT(data);
@@ -112,78 +553,134 @@ Rml::FontEngineInterface* SkiaBackend::GetFontEngineInterface()
 Rml::RenderInterface* SkiaBackend::GetRenderInterface()
 {
   RMLUI_ASSERT(data);
-  return &data->render_interface;
+  return data->instance->GetRenderInterface();
 }
 
-/*
-bool SkiaBackend::ProcessEvents(Rml::Context* context, KeyDownCallback key_down_callback, bool power_save)
-{
-	RMLUI_ASSERT(data && context);
-
-#if SDL_MAJOR_VERSION >= 3
-	auto GetKey = [](const SDL_Event& event) { return event.key.key; };
-	auto GetDisplayScale = []() { return SDL_GetWindowDisplayScale(data->window); };
-	constexpr auto event_quit = SDL_EVENT_QUIT;
-	constexpr auto event_key_down = SDL_EVENT_KEY_DOWN;
-	bool has_event = false;
-#else
-	auto GetKey = [](const SDL_Event& event) { return event.key.keysym.sym; };
-	auto GetDisplayScale = []() { return 1.f; };
-	constexpr auto event_quit = SDL_QUIT;
-	constexpr auto event_key_down = SDL_KEYDOWN;
-	int has_event = 0;
-#endif
-
-	bool result = data->running;
-	data->running = true;
-
-	SDL_Event ev;
-	if (power_save)
-		has_event = SDL_WaitEventTimeout(&ev, static_cast<int>(Rml::Math::Min(context->GetNextUpdateDelay(), 10.0) * 1000));
-	else
-		has_event = SDL_PollEvent(&ev);
-
-	while (has_event)
-	{
-		bool propagate_event = true;
-		switch (ev.type)
-		{
-		case event_quit:
-		{
-			propagate_event = false;
-			result = false;
-		}
-		break;
-		case event_key_down:
-		{
-			propagate_event = false;
-			const Rml::Input::KeyIdentifier key = RmlSDL::ConvertKey(GetKey(ev));
-			const int key_modifier = RmlSDL::GetKeyModifierState();
-			const float native_dp_ratio = GetDisplayScale();
-
-			// See if we have any global shortcuts that take priority over the context.
-			if (key_down_callback && !key_down_callback(context, key, key_modifier, native_dp_ratio, true))
-				break;
-			// Otherwise, hand the event over to the context by calling the input handler as normal.
-			if (!RmlSDL::InputEventHandler(context, data->window, ev))
-				break;
-			// The key was not consumed by the context either, try keyboard shortcuts of lower priority.
-			if (key_down_callback && !key_down_callback(context, key, key_modifier, native_dp_ratio, false))
-				break;
-		}
-		break;
-		default: break;
-		}
-
-		if (propagate_event)
-			RmlSDL::InputEventHandler(context, data->window, ev);
-
-		has_event = SDL_PollEvent(&ev);
-	}
-
-	return result;
-}
-*/
+SkiaBackend::Instance* SkiaBackend::GetInstance()
+{
+  RMLUI_ASSERT(data);
+  return data->instance.get();
+}
+
+Rml::Span<const Rml::byte> SkiaBackend::GetPixels()
+{
+  RMLUI_ASSERT(data);
+  return data->instance->GetPixels();
+}
+
+size_t SkiaBackend::GetRowBytes()
+{
+  RMLUI_ASSERT(data);
+  return data->instance->GetRowBytes();
+}
+
+SkColorType SkiaBackend::GetColorType()
+{
+  RMLUI_ASSERT(data);
+  return data->instance->GetColorType();
+}
+
+bool SkiaBackend::StartPresentThread(int buffer_count, PresentCallback callback)
+{
+  RMLUI_ASSERT(data);
+  return data->instance->StartPresentThread(buffer_count, std::move(callback));
+}
+
+void SkiaBackend::StopPresentThread()
+{
+  RMLUI_ASSERT(data);
+  data->instance->StopPresentThread();
+}
+
+void SkiaBackend::SetEventSource(EventSource* event_source)
+{
+  RMLUI_ASSERT(data);
+  data->event_source = event_source;
+}
+
+bool SkiaBackend::ProcessEvents(Rml::Context* context, bool power_save)
+{
+  RMLUI_ASSERT(data && context);
+
+  bool result = data->running;
+  data->running = true;
+
+  // The delay counts from the last update, which computed it.
+  const double now = GetElapsedTime();
+  const double updateTime = data->update_pending
+      ? now
+      : data->last_update_time + context->GetNextUpdateDelay();
+
+  // The delay is infinite while the context is idle, the wait is capped so
+  // the loop stays responsive to RequestExit().
+  const double timeout = power_save
+      ? Rml::Math::Clamp(updateTime - now, 0.0, MAX_EVENT_WAIT)
+      : 0.0;
+
+  SkiaBackend::EventSource* eventSource = data->event_source;
+  bool hasEvents = false;
+  if(eventSource) {
+    hasEvents = eventSource->WaitForEvents(timeout);
+  } else if(timeout > 0) {
+    std::unique_lock<std::mutex> lock(data->request_mutex);
+    data->request_condition.wait_for(
+        lock, std::chrono::duration<double>(timeout),
+        []() { return data->update_pending.load(); });
+  }
+
+  if(hasEvents) {
+    result = eventSource->ProcessEvents(context) && result;
+  }
+
+  if(!power_save || hasEvents
+     || GetElapsedTime() >= updateTime) {
+    data->update_pending = true;
+  }
+
+  return result;
+}
+
+bool SkiaBackend::ProcessFrame(Rml::Context* context, bool power_save)
+{
+  RMLUI_ASSERT(data && context);
+
+  const bool running = ProcessEvents(context, power_save);
+
+  if(!data->update_pending.exchange(false)) {
+    ++data->schedule_stats.skipped_frames;
+    return running;
+  }
+
+  data->last_update_time = GetElapsedTime();
+
+  context->Update();
+  BeginFrame();
+  context->Render();
+  PresentFrame();
+
+  ++data->schedule_stats.rendered_frames;
+  return running;
+}
+
+void SkiaBackend::RequestFrame()
+{
+  RMLUI_ASSERT(data);
+  {
+    std::lock_guard<std::mutex> lock(data->request_mutex);
+    data->update_pending = true;
+  }
+  data->request_condition.notify_one();
+
+  if(SkiaBackend::EventSource* eventSource = data->event_source) {
+    eventSource->Wake();
+  }
+}
+
+const SkiaBackend::ScheduleStats& SkiaBackend::GetScheduleStats()
+{
+  RMLUI_ASSERT(data);
+  return data->schedule_stats;
+}
 
 void SkiaBackend::RequestExit()
 {
@@ -194,11 +691,11 @@ void SkiaBackend::RequestExit()
 void SkiaBackend::BeginFrame()
 {
   RMLUI_ASSERT(data);
-  data->render_interface.BeginFrame();
+  data->instance->BeginFrame();
 }
 
-void SkiaBackend::PresentFrame()
+const Rml::Vector<Rml::Rectanglei>& SkiaBackend::PresentFrame()
 {
   RMLUI_ASSERT(data);
-  data->render_interface.EndFrame();
+  return data->instance->PresentFrame();
 }
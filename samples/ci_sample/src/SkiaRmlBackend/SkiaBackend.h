@@ -37,6 +37,15 @@
 #include <RmlUi/Core/SystemInterface.h>
 #include <RmlUi/Core/Types.h>
 
+#include "include/core/SkColorType.h"
+
+#include <cstdint>
+#include <functional>
+
+class SkCanvas;
+class SkSurface;
+class SkiaRenderInterface;
+
 // using KeyDownCallback = bool (*)(
 //     Rml::Context* context,
 //     Rml::Input::KeyIdentifier key,
@@ -59,10 +68,157 @@
 namespace SkiaBackend
 {
 
+// A finished frame handed to the present callback. The pixels stay valid
+// until the callback returns.
+struct Frame
+{
+  // Counts the presented frames of the instance from 1.
+  uint64_t index = 0;
+  Rml::Span<const Rml::byte> pixels;
+  size_t row_bytes = 0;
+  int width = 0;
+  int height = 0;
+  SkColorType color_type = kUnknown_SkColorType;
+};
+
+// Called on the present thread for every frame in order.
+using PresentCallback = std::function<void(const Frame& frame)>;
+
+// Source of the input events of the backend, set with SetEventSource().
+class EventSource
+{
+public:
+  virtual ~EventSource() = default;
+
+  // Waits up to 'timeout' seconds, returns true as soon as events are
+  // pending. Returns at once for a zero timeout.
+  virtual bool WaitForEvents(double timeout) = 0;
+
+  // Ends the WaitForEvents() in progress, or else makes the next one return
+  // at once. Called by RequestFrame(), on any thread.
+  virtual void Wake() = 0;
+
+  // Applies the pending events to 'context'.
+  // @return False to indicate that the application should be closed.
+  virtual bool ProcessEvents(Rml::Context* context) = 0;
+};
+
+// Counters of the frame loop run by ProcessFrame().
+struct ScheduleStats
+{
+  uint64_t rendered_frames = 0;
+  // Iterations without pending events or updates, which neither updated
+  // nor rendered the context.
+  uint64_t skipped_frames = 0;
+};
+
+// A surface with its canvas and render interface. Instances are independent
+// of each other and of the backend, each can render its own contexts, and
+// the canvas work of separate instances can run on separate threads. RmlUi
+// itself is not thread-safe, calls into RmlUi must still be serialized.
+class Instance
+{
+public:
+  // The surface and the textures use 'color_type', the native kN32 order
+  // avoids swizzling on every draw. kRGB_565_SkColorType and
+  // kGray_8_SkColorType surfaces suit low bit depth framebuffers, see
+  // SkiaRenderInterface::SetDitheringEnabled(). Returns null if the surface
+  // can not be created.
+  static Rml::UniquePtr<Instance> Create(
+      int width, int height, SkColorType color_type = kN32_SkColorType);
+  // Renders straight into caller memory of at least 'height' rows of
+  // 'row_bytes' bytes, which must outlive the instance. Returns null if the
+  // surface can not be created or the rows are too short.
+  static Rml::UniquePtr<Instance> CreateDirect(
+      int width,
+      int height,
+      void* pixels,
+      size_t row_bytes,
+      SkColorType color_type = kN32_SkColorType);
+
+  ~Instance();
+
+  Instance(const Instance&) = delete;
+  Instance& operator=(const Instance&) = delete;
+
+  SkSurface* GetSurface();
+  SkCanvas* GetCanvas();
+
+  // The pixels of the last finished frame without copying, rows of
+  // GetRowBytes() bytes. Valid until its surface is drawn to again.
+  Rml::Span<const Rml::byte> GetPixels();
+  size_t GetRowBytes();
+  SkColorType GetColorType();
+
+  // The render interface to pass to Rml::CreateContext() for the contexts
+  // rendered to this instance.
+  SkiaRenderInterface* GetRenderInterface();
+
+  // Prepares the render state to accept rendering commands from RmlUi.
+  void BeginFrame();
+
+  // Finishes the frame. With a present thread, hands the frame to it and
+  // switches to the next buffer, waiting until that one is presented.
+  // @return The regions of the surface changed by the frame.
+  const Rml::Vector<Rml::Rectanglei>& PresentFrame();
+
+  // Presents the frames on a thread calling 'callback', while the next frames
+  // are rendered into the other of 'buffer_count' surfaces, 2 or 3 for double
+  // or triple buffering. The surface and canvas of the instance change with
+  // every frame. Returns false for instances rendering into caller memory.
+  bool StartPresentThread(int buffer_count, PresentCallback callback);
+  // Presents the queued frames and stops the thread, the instance renders
+  // into the surface of the last frame again.
+  void StopPresentThread();
+
+  // Resizes the surfaces, keeping the render interface with its geometry and
+  // textures. The pixel memory is reused if the new size fits, and grows
+  // geometrically otherwise. The pixels of the last frame are lost. Returns
+  // false for instances rendering into caller memory or if the memory can
+  // not be allocated.
+  bool Resize(int width, int height);
+
+  // The fence of the present thread: the index of the last finished frame,
+  // and of the last frame the callback returned from. Without a present
+  // thread frames are presented when they are finished.
+  uint64_t GetFinishedFrame();
+  uint64_t GetPresentedFrame();
+  // Waits until the callback returned from 'frame'.
+  void WaitForFrame(uint64_t frame);
+
+private:
+  struct Data;
+
+  bool TakeBufferPixmaps();
+
+  explicit Instance(Rml::UniquePtr<Data> data);
+
+  Rml::UniquePtr<Data> data;
+};
+
 // Initializes the backend, including the custom system and render interfaces,
 // and opens a window for rendering the RmlUi context.
 bool Initialize(
-    const char* window_name, int width, int height, bool allow_resize);
+    const char* window_name,
+    int width,
+    int height,
+    bool allow_resize,
+    SkColorType color_type = kN32_SkColorType);
+
+// Initializes the backend to render into caller memory, see
+// Instance::CreateDirect().
+bool Initialize(
+    const char* window_name,
+    int width,
+    int height,
+    void* pixels,
+    size_t row_bytes,
+    SkColorType color_type = kN32_SkColorType);
+
+// Resizes the surface, keeping the font engine and the textures, see
+// Instance::Resize(). Fails unless the backend was initialized with
+// 'allow_resize'. The dimensions of the RmlUi contexts are set separately.
+bool Resize(int width, int height);
 
 // Closes the window and release all resources owned by the backend, including
 // the system and render interfaces.
@@ -80,13 +236,43 @@ Rml::FontEngineInterface* GetFontEngineInterface();
 // RmlUi.
 Rml::RenderInterface* GetRenderInterface();
 
-// Polls and processes events from the current platform, and applies any
-// relevant events to the provided RmlUi context and the key down callback.
+// Returns the instance the backend renders to.
+Instance* GetInstance();
+
+// Returns the pixels of the last presented frame without copying, rows of
+// GetRowBytes() bytes in GetColorType() order.
+Rml::Span<const Rml::byte> GetPixels();
+size_t GetRowBytes();
+SkColorType GetColorType();
+
+// Sets the source of the input events, null for none. The source is not
+// owned and must outlive the backend or be reset.
+void SetEventSource(EventSource* event_source);
+
+// Processes the events of the event source, and applies them to the provided
+// RmlUi context. In power save mode, waits for events until the context needs
+// its next update, see Rml::Context::GetNextUpdateDelay(). The delay counts
+// from the last update, on the clock of the installed system interface.
 // @return False to indicate that the application should be closed.
-// bool ProcessEvents(
-//     Rml::Context* context,
-//     KeyDownCallback key_down_callback = nullptr,
-//     bool power_save = false);
+bool ProcessEvents(Rml::Context* context, bool power_save = false);
+
+// Runs one iteration of the frame loop: processes the events, and if any were
+// pending, an update is due or a frame was requested, updates and renders
+// the context and presents the frame. Otherwise the frame is skipped.
+// @return False to indicate that the application should be closed.
+bool ProcessFrame(Rml::Context* context, bool power_save = true);
+
+// Makes the next ProcessFrame() render, for changes made outside of the
+// event source, like loading a document. May be called on any thread, for
+// example by the texture loaded callback of SkiaRenderInterface. Ends the wait
+// of ProcessEvents(), waking the event source if one is set.
+void RequestFrame();
+
+const ScheduleStats& GetScheduleStats();
+
+// Presents the frames on a thread, see Instance::StartPresentThread().
+bool StartPresentThread(int buffer_count, PresentCallback callback);
+void StopPresentThread();
 
 // Request application closure during the next event processing call.
 void RequestExit();
@@ -97,7 +283,8 @@ void BeginFrame();
 
 // Presents the rendered frame to the screen, call after rendering the RmlUi
 // context.
-void PresentFrame();
+// @return The regions of the surface changed by the frame.
+const Rml::Vector<Rml::Rectanglei>& PresentFrame();
 
 }  // namespace SkiaBackend
 
@@ -0,0 +1,105 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#include "SkiaFrameArena.h"
+
+#include <RmlUi/Core/Core.h>
+
+#include <new>
+
+SkiaFrameArena::SkiaFrameArena(size_t block_size)
+    : block_size {block_size}
+{
+}
+
+void* SkiaFrameArena::Allocate(size_t size, size_t alignment)
+{
+  RMLUI_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+  while(current_block < blocks.size()) {
+    Block& block = blocks[current_block];
+    auto base = reinterpret_cast<uintptr_t>(block.data.get());
+    size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+
+    if(aligned + size <= block.size) {
+      offset = aligned + size;
+      return block.data.get() + aligned;
+    }
+
+    ++current_block;
+    offset = 0;
+  }
+
+  if(!AllocateBlock(size + alignment)) {
+    return nullptr;
+  }
+
+  return Allocate(size, alignment);
+}
+
+void SkiaFrameArena::Reset()
+{
+  block_allocations = 0;
+
+  if(current_block > 0) {
+    // The frame spilled over several blocks, use one block for all of it.
+    size_t total = 0;
+    for(const Block& block : blocks) {
+      total += block.size;
+    }
+
+    blocks.clear();
+    AllocateBlock(total);
+  }
+
+  current_block = 0;
+  offset = 0;
+}
+
+int SkiaFrameArena::GetBlockAllocations() const
+{
+  return block_allocations;
+}
+
+bool SkiaFrameArena::AllocateBlock(size_t min_size)
+{
+  Block block;
+  block.size = Rml::Math::Max(block_size, min_size);
+  block.data.reset(new(std::nothrow) Rml::byte[block.size]);
+  if(!block.data) {
+    return false;
+  }
+
+  blocks.push_back(std::move(block));
+  current_block = blocks.size() - 1;
+  offset = 0;
+  ++block_allocations;
+  return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#ifndef SKIARMLBACKEND_SKIAFRAMEARENA_H
+#define SKIARMLBACKEND_SKIAFRAMEARENA_H
+
+#include <RmlUi/Core/Types.h>
+
+#include <type_traits>
+
+// Bump allocator for scratch memory of the render path. Memory is handed out
+// from large blocks and is released all at once by Reset(), the blocks are
+// kept for the next frame.
+class SkiaFrameArena
+{
+public:
+  explicit SkiaFrameArena(size_t block_size = 64 * 1024);
+
+  SkiaFrameArena(const SkiaFrameArena&) = delete;
+  SkiaFrameArena& operator=(const SkiaFrameArena&) = delete;
+
+  // Returns uninitialized memory valid until the next Reset().
+  void* Allocate(size_t size, size_t alignment);
+
+  template<typename T>
+  T* Allocate(size_t count)
+  {
+    static_assert(
+        std::is_trivially_destructible<T>::value,
+        "Arena memory is released without calling destructors.");
+    return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // Makes all memory available again. If the last frame did not fit in one
+  // block, the blocks are replaced by a single block large enough for it.
+  void Reset();
+
+  // Number of blocks allocated since the last Reset(), including the block
+  // allocated by that Reset().
+  int GetBlockAllocations() const;
+
+private:
+  struct Block
+  {
+    Rml::UniquePtr<Rml::byte[]> data;
+    size_t size = 0;
+  };
+
+  bool AllocateBlock(size_t min_size);
+
+  size_t block_size;
+  Rml::Vector<Block> blocks;
+  size_t current_block = 0;
+  size_t offset = 0;
+  int block_allocations = 0;
+};
+
+#endif  // SKIARMLBACKEND_SKIAFRAMEARENA_H
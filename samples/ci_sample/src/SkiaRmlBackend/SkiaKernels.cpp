@@ -0,0 +1,810 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#include "SkiaKernels.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) \
+    || defined(_M_IX86)
+#define SKIAKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#define SKIAKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SKIAKERNELS_TARGET(isa)
+#else
+#define SKIAKERNELS_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// The SIMD kernels read the vertices as five 32-bit lanes:
+// position.x, position.y, colour, tex_coord.x, tex_coord.y.
+static_assert(sizeof(Rml::Vertex) == 20, "Unexpected Rml::Vertex layout.");
+static_assert(offsetof(Rml::Vertex, position) == 0, "Unexpected Rml::Vertex layout.");
+static_assert(offsetof(Rml::Vertex, colour) == 8, "Unexpected Rml::Vertex layout.");
+static_assert(offsetof(Rml::Vertex, tex_coord) == 12, "Unexpected Rml::Vertex layout.");
+static_assert(sizeof(SkPoint) == 8, "Unexpected SkPoint layout.");
+
+SkColor SkiaKernels::ConvertColor(Rml::ColourbPremultiplied color)
+{
+  const int alpha = color.alpha;
+  if(alpha == 255 || alpha == 0) {
+    return SkColorSetARGB(alpha, color.red, color.green, color.blue);
+  }
+
+  // Rounded c * 255 / a, clamped for colours which are not premultiplied.
+  auto unpremultiply = [alpha](int c) {
+    return static_cast<U8CPU>(std::min((c * 255 + alpha / 2) / alpha, 255));
+  };
+  return SkColorSetARGB(
+      alpha, unpremultiply(color.red), unpremultiply(color.green),
+      unpremultiply(color.blue));
+}
+
+using ConvertVerticesFunction = void (*)(
+    const Rml::Vertex*,
+    int,
+    Rml::Vector2f,
+    Rml::Vector2f,
+    SkPoint*,
+    SkPoint*,
+    SkColor*);
+
+void SkiaKernels::ConvertVerticesScalar(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors)
+{
+  for(int i = 0; i < count; ++i) {
+    const Rml::Vertex& vert = vertices[i];
+    positions[i] = SkPoint::Make(
+        vert.position.x + translation.x, vert.position.y + translation.y);
+
+    if(tex_coords) {
+      tex_coords[i] = SkPoint::Make(
+          vert.tex_coord.x * tex_scale.x, vert.tex_coord.y * tex_scale.y);
+    }
+
+    if(colors) {
+      colors[i] = SkiaKernels::ConvertColor(vert.colour);
+    }
+  }
+}
+
+// Unpremultiplies the translucent colours swizzled by a SIMD kernel, RmlUi
+// colours are mostly opaque and are left as they are.
+static void UnpremultiplyColors(SkColor* colors, int count)
+{
+  for(int i = 0; i < count; ++i) {
+    const SkColor color = colors[i];
+    const U8CPU alpha = SkColorGetA(color);
+    if(alpha != 255) {
+      colors[i] = SkiaKernels::ConvertColor(Rml::ColourbPremultiplied(
+          static_cast<Rml::byte>(SkColorGetR(color)),
+          static_cast<Rml::byte>(SkColorGetG(color)),
+          static_cast<Rml::byte>(SkColorGetB(color)),
+          static_cast<Rml::byte>(alpha)));
+    }
+  }
+}
+
+using ConvertTgaPixelsFunction =
+    bool (*)(const Rml::byte*, int, int, bool, Rml::byte*);
+
+// c * a / 255, truncated like the division of the scalar kernel.
+static inline Rml::byte Premultiply(Rml::byte c, Rml::byte a)
+{
+  return static_cast<Rml::byte>((c * a) / 255);
+}
+
+bool SkiaKernels::ConvertTgaPixelsScalar(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest)
+{
+  // TGA pixels are BGR(A).
+  const int red = dest_rgba ? 2 : 0;
+  const int blue = dest_rgba ? 0 : 2;
+  bool opaque = true;
+
+  for(int i = 0; i < count; ++i) {
+    const Rml::byte alpha = source_bytes == 4 ? source[3] : 255;
+    dest[0] = Premultiply(source[red], alpha);
+    dest[1] = Premultiply(source[1], alpha);
+    dest[2] = Premultiply(source[blue], alpha);
+    dest[3] = alpha;
+    opaque = opaque && alpha == 255;
+
+    source += source_bytes;
+    dest += 4;
+  }
+
+  return opaque;
+}
+
+#ifdef SKIAKERNELS_X86
+
+// Little-endian RGBA bytes to ARGB words: swaps the red and blue bytes.
+SKIAKERNELS_TARGET("sse2")
+static inline __m128i SwizzleColorsSSE2(__m128i c)
+{
+  const __m128i mask_ag = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+  const __m128i mask_b = _mm_set1_epi32(0xFF);
+  __m128i ag = _mm_and_si128(c, mask_ag);
+  __m128i r = _mm_slli_epi32(_mm_and_si128(c, mask_b), 16);
+  __m128i b = _mm_and_si128(_mm_srli_epi32(c, 16), mask_b);
+  return _mm_or_si128(ag, _mm_or_si128(r, b));
+}
+
+SKIAKERNELS_TARGET("sse2")
+static void ConvertVerticesSSE2(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors)
+{
+  const __m128 offset =
+      _mm_setr_ps(translation.x, translation.y, translation.x, translation.y);
+  const __m128 scale =
+      _mm_setr_ps(tex_scale.x, tex_scale.y, tex_scale.x, tex_scale.y);
+
+  int i = 0;
+  for(; i + 4 <= count; i += 4) {
+    // Four vertices are 20 lanes:
+    // l0 = x0 y0 c0 u0, l1 = v0 x1 y1 c1, l2 = u1 v1 x2 y2,
+    // l3 = c2 u2 v2 x3, l4 = y3 c3 u3 v3.
+    const float* src = reinterpret_cast<const float*>(vertices + i);
+    __m128 l0 = _mm_loadu_ps(src);
+    __m128 l1 = _mm_loadu_ps(src + 4);
+    __m128 l2 = _mm_loadu_ps(src + 8);
+    __m128 l3 = _mm_loadu_ps(src + 12);
+    __m128 l4 = _mm_loadu_ps(src + 16);
+
+    __m128 x3y3 = _mm_shuffle_ps(l3, l4, _MM_SHUFFLE(0, 0, 3, 3));
+    __m128 pos01 = _mm_shuffle_ps(l0, l1, _MM_SHUFFLE(2, 1, 1, 0));
+    __m128 pos23 = _mm_shuffle_ps(l2, x3y3, _MM_SHUFFLE(2, 0, 3, 2));
+    _mm_storeu_ps(reinterpret_cast<float*>(positions + i), _mm_add_ps(pos01, offset));
+    _mm_storeu_ps(reinterpret_cast<float*>(positions + i + 2), _mm_add_ps(pos23, offset));
+
+    if(tex_coords) {
+      __m128 u0v0 = _mm_shuffle_ps(l0, l1, _MM_SHUFFLE(0, 0, 3, 3));
+      __m128 tex01 = _mm_shuffle_ps(u0v0, l2, _MM_SHUFFLE(1, 0, 2, 0));
+      __m128 tex23 = _mm_shuffle_ps(l3, l4, _MM_SHUFFLE(3, 2, 2, 1));
+      _mm_storeu_ps(reinterpret_cast<float*>(tex_coords + i), _mm_mul_ps(tex01, scale));
+      _mm_storeu_ps(reinterpret_cast<float*>(tex_coords + i + 2), _mm_mul_ps(tex23, scale));
+    }
+
+    if(colors) {
+      __m128 c01 = _mm_shuffle_ps(l0, l1, _MM_SHUFFLE(3, 3, 2, 2));
+      __m128 c23 = _mm_shuffle_ps(l3, l4, _MM_SHUFFLE(1, 1, 0, 0));
+      __m128i c = _mm_castps_si128(_mm_shuffle_ps(c01, c23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), SwizzleColorsSSE2(c));
+    }
+  }
+
+  if(colors) {
+    UnpremultiplyColors(colors, i);
+  }
+
+  SkiaKernels::ConvertVerticesScalar(
+      vertices + i, count - i, translation, tex_scale, positions + i,
+      tex_coords ? tex_coords + i : nullptr, colors ? colors + i : nullptr);
+}
+
+// Premultiplies two BGRA pixels held as 16-bit words, and swaps the red and
+// blue words for RGBA.
+template<bool DEST_RGBA>
+SKIAKERNELS_TARGET("sse2")
+static inline __m128i PremultiplyWordsSSE2(__m128i c)
+{
+  // The alpha words are multiplied by 255, which keeps them.
+  const __m128i alpha_mask = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+  __m128i a = _mm_shufflehi_epi16(
+      _mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  a = _mm_or_si128(
+      _mm_andnot_si128(alpha_mask, a),
+      _mm_and_si128(alpha_mask, _mm_set1_epi16(255)));
+
+  // (x + 1 + (x >> 8)) >> 8 == x / 255 for x <= 255 * 255.
+  __m128i x = _mm_mullo_epi16(c, a);
+  x = _mm_srli_epi16(
+      _mm_add_epi16(
+          _mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)),
+      8);
+
+  if(DEST_RGBA) {
+    x = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 0, 1, 2)),
+        _MM_SHUFFLE(3, 0, 1, 2));
+  }
+  return x;
+}
+
+template<bool DEST_RGBA>
+SKIAKERNELS_TARGET("sse2")
+static bool ConvertBgraPixelsSSE2(
+    const Rml::byte* source, int count, Rml::byte* dest)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i alpha_and = _mm_set1_epi8(-1);
+
+  int i = 0;
+  for(; i + 4 <= count; i += 4) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+    alpha_and = _mm_and_si128(alpha_and, v);
+
+    __m128i lo = PremultiplyWordsSSE2<DEST_RGBA>(_mm_unpacklo_epi8(v, zero));
+    __m128i hi = PremultiplyWordsSSE2<DEST_RGBA>(_mm_unpackhi_epi8(v, zero));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dest + i * 4), _mm_packus_epi16(lo, hi));
+  }
+
+  // The alpha bytes are the 4th of every pixel.
+  const int alpha_bits =
+      _mm_movemask_epi8(_mm_cmpeq_epi8(alpha_and, _mm_set1_epi8(-1)));
+  const bool opaque = (alpha_bits & 0x8888) == 0x8888;
+
+  return SkiaKernels::ConvertTgaPixelsScalar(
+             source + i * 4, 4, count - i, DEST_RGBA, dest + i * 4)
+      && opaque;
+}
+
+// BGR pixels need byte shuffles, which SSE2 lacks, they take the scalar
+// kernel.
+SKIAKERNELS_TARGET("sse2")
+static bool ConvertTgaPixelsSSE2(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest)
+{
+  if(source_bytes != 4) {
+    return SkiaKernels::ConvertTgaPixelsScalar(
+        source, source_bytes, count, dest_rgba, dest);
+  }
+
+  return dest_rgba ? ConvertBgraPixelsSSE2<true>(source, count, dest)
+                   : ConvertBgraPixelsSSE2<false>(source, count, dest);
+}
+
+SKIAKERNELS_TARGET("avx2")
+static inline __m256 LoadLanesAVX2(const float* lo, const float* hi)
+{
+  return _mm256_insertf128_ps(
+      _mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+}
+
+SKIAKERNELS_TARGET("avx2")
+static void ConvertVerticesAVX2(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors)
+{
+  const __m256 offset = _mm256_setr_ps(
+      translation.x, translation.y, translation.x, translation.y,
+      translation.x, translation.y, translation.x, translation.y);
+  const __m256 scale = _mm256_setr_ps(
+      tex_scale.x, tex_scale.y, tex_scale.x, tex_scale.y, tex_scale.x,
+      tex_scale.y, tex_scale.x, tex_scale.y);
+  // Swaps the red and blue bytes of each colour.
+  const __m256i swizzle = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+  int i = 0;
+  for(; i + 8 <= count; i += 8) {
+    // The 128-bit lanes hold vertices i..i+3 and i+4..i+7, and are shuffled
+    // the same way as in the SSE2 kernel.
+    const float* lo = reinterpret_cast<const float*>(vertices + i);
+    const float* hi = reinterpret_cast<const float*>(vertices + i + 4);
+    __m256 l0 = LoadLanesAVX2(lo, hi);
+    __m256 l1 = LoadLanesAVX2(lo + 4, hi + 4);
+    __m256 l2 = LoadLanesAVX2(lo + 8, hi + 8);
+    __m256 l3 = LoadLanesAVX2(lo + 12, hi + 12);
+    __m256 l4 = LoadLanesAVX2(lo + 16, hi + 16);
+
+    __m256 x3y3 = _mm256_shuffle_ps(l3, l4, _MM_SHUFFLE(0, 0, 3, 3));
+    __m256 pos01 = _mm256_add_ps(
+        _mm256_shuffle_ps(l0, l1, _MM_SHUFFLE(2, 1, 1, 0)), offset);
+    __m256 pos23 = _mm256_add_ps(
+        _mm256_shuffle_ps(l2, x3y3, _MM_SHUFFLE(2, 0, 3, 2)), offset);
+    float* pos = reinterpret_cast<float*>(positions + i);
+    _mm256_storeu_ps(pos, _mm256_permute2f128_ps(pos01, pos23, 0x20));
+    _mm256_storeu_ps(pos + 8, _mm256_permute2f128_ps(pos01, pos23, 0x31));
+
+    if(tex_coords) {
+      __m256 u0v0 = _mm256_shuffle_ps(l0, l1, _MM_SHUFFLE(0, 0, 3, 3));
+      __m256 tex01 = _mm256_mul_ps(
+          _mm256_shuffle_ps(u0v0, l2, _MM_SHUFFLE(1, 0, 2, 0)), scale);
+      __m256 tex23 = _mm256_mul_ps(
+          _mm256_shuffle_ps(l3, l4, _MM_SHUFFLE(3, 2, 2, 1)), scale);
+      float* tex = reinterpret_cast<float*>(tex_coords + i);
+      _mm256_storeu_ps(tex, _mm256_permute2f128_ps(tex01, tex23, 0x20));
+      _mm256_storeu_ps(tex + 8, _mm256_permute2f128_ps(tex01, tex23, 0x31));
+    }
+
+    if(colors) {
+      __m256 c01 = _mm256_shuffle_ps(l0, l1, _MM_SHUFFLE(3, 3, 2, 2));
+      __m256 c23 = _mm256_shuffle_ps(l3, l4, _MM_SHUFFLE(1, 1, 0, 0));
+      __m256i c = _mm256_castps_si256(
+          _mm256_shuffle_ps(c01, c23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(colors + i),
+          _mm256_shuffle_epi8(c, swizzle));
+    }
+  }
+
+  if(colors) {
+    UnpremultiplyColors(colors, i);
+  }
+
+  ConvertVerticesSSE2(
+      vertices + i, count - i, translation, tex_scale, positions + i,
+      tex_coords ? tex_coords + i : nullptr, colors ? colors + i : nullptr);
+}
+
+template<bool DEST_RGBA>
+SKIAKERNELS_TARGET("avx2")
+static inline __m256i PremultiplyWordsAVX2(__m256i c)
+{
+  // The same steps as PremultiplyWordsSSE2(), on four pixels.
+  const __m256i alpha_mask = _mm256_setr_epi16(
+      0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+  __m256i a = _mm256_shufflehi_epi16(
+      _mm256_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)),
+      _MM_SHUFFLE(3, 3, 3, 3));
+  a = _mm256_or_si256(
+      _mm256_andnot_si256(alpha_mask, a),
+      _mm256_and_si256(alpha_mask, _mm256_set1_epi16(255)));
+
+  __m256i x = _mm256_mullo_epi16(c, a);
+  x = _mm256_srli_epi16(
+      _mm256_add_epi16(
+          _mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_srli_epi16(x, 8)),
+      8);
+
+  if(DEST_RGBA) {
+    x = _mm256_shufflehi_epi16(
+        _mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 0, 1, 2)),
+        _MM_SHUFFLE(3, 0, 1, 2));
+  }
+  return x;
+}
+
+template<bool DEST_RGBA>
+SKIAKERNELS_TARGET("avx2")
+static bool ConvertBgraPixelsAVX2(
+    const Rml::byte* source, int count, Rml::byte* dest)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i alpha_and = _mm256_set1_epi8(-1);
+
+  int i = 0;
+  for(; i + 8 <= count; i += 8) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+    alpha_and = _mm256_and_si256(alpha_and, v);
+
+    // Unpacking and packing work within the 128-bit lanes, which keeps the
+    // pixel order.
+    __m256i lo =
+        PremultiplyWordsAVX2<DEST_RGBA>(_mm256_unpacklo_epi8(v, zero));
+    __m256i hi =
+        PremultiplyWordsAVX2<DEST_RGBA>(_mm256_unpackhi_epi8(v, zero));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dest + i * 4), _mm256_packus_epi16(lo, hi));
+  }
+
+  const unsigned alpha_bits = static_cast<unsigned>(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(alpha_and, _mm256_set1_epi8(-1))));
+  const bool opaque = (alpha_bits & 0x88888888u) == 0x88888888u;
+
+  return SkiaKernels::ConvertTgaPixelsScalar(
+             source + i * 4, 4, count - i, DEST_RGBA, dest + i * 4)
+      && opaque;
+}
+
+SKIAKERNELS_TARGET("avx2")
+static bool ConvertBgrPixelsAVX2(
+    const Rml::byte* source, int count, bool dest_rgba, Rml::byte* dest)
+{
+  // Expands four 3-byte pixels to 4 bytes, with opaque alpha.
+  const __m128i shuffle = dest_rgba
+      ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+      : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+  // A 16-byte load reads 4 bytes past the four pixels.
+  int i = 0;
+  for(; i + 6 <= count; i += 4) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dest + i * 4),
+        _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+  }
+
+  SkiaKernels::ConvertTgaPixelsScalar(
+      source + i * 3, 3, count - i, dest_rgba, dest + i * 4);
+  return true;
+}
+
+SKIAKERNELS_TARGET("avx2")
+static bool ConvertTgaPixelsAVX2(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest)
+{
+  if(source_bytes != 4) {
+    return ConvertBgrPixelsAVX2(source, count, dest_rgba, dest);
+  }
+
+  return dest_rgba ? ConvertBgraPixelsAVX2<true>(source, count, dest)
+                   : ConvertBgraPixelsAVX2<false>(source, count, dest);
+}
+
+static bool HasSSE2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+  return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+#else
+  return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool HasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if(info[0] < 7) {
+    return false;
+  }
+
+  // The OS must save the YMM registers.
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  if(!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif  // SKIAKERNELS_X86
+
+#ifdef SKIAKERNELS_NEON
+
+static inline uint32x4_t SwizzleColorsNEON(uint32x4_t c)
+{
+  uint32x4_t ag = vandq_u32(c, vdupq_n_u32(0xFF00FF00));
+  uint32x4_t r = vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0xFF)), 16);
+  uint32x4_t b = vandq_u32(vshrq_n_u32(c, 16), vdupq_n_u32(0xFF));
+  return vorrq_u32(ag, vorrq_u32(r, b));
+}
+
+static void ConvertVerticesNEON(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors)
+{
+  const float offset_data[4] = {
+      translation.x, translation.y, translation.x, translation.y};
+  const float scale_data[4] = {
+      tex_scale.x, tex_scale.y, tex_scale.x, tex_scale.y};
+  const float32x4_t offset = vld1q_f32(offset_data);
+  const float32x4_t scale = vld1q_f32(scale_data);
+
+  int i = 0;
+  for(; i + 4 <= count; i += 4) {
+    // Same lane layout as in the SSE2 kernel.
+    const float* src = reinterpret_cast<const float*>(vertices + i);
+    float32x4_t l0 = vld1q_f32(src);
+    float32x4_t l1 = vld1q_f32(src + 4);
+    float32x4_t l2 = vld1q_f32(src + 8);
+    float32x4_t l3 = vld1q_f32(src + 12);
+    float32x4_t l4 = vld1q_f32(src + 16);
+
+    float32x4_t pos01 = vcombine_f32(
+        vget_low_f32(l0), vget_low_f32(vextq_f32(l1, l1, 1)));
+    float32x4_t pos23 = vcombine_f32(
+        vget_high_f32(l2), vget_low_f32(vextq_f32(l3, l4, 3)));
+    float* pos = reinterpret_cast<float*>(positions + i);
+    vst1q_f32(pos, vaddq_f32(pos01, offset));
+    vst1q_f32(pos + 4, vaddq_f32(pos23, offset));
+
+    if(tex_coords) {
+      float32x4_t tex01 = vcombine_f32(
+          vget_low_f32(vextq_f32(l0, l1, 3)), vget_low_f32(l2));
+      float32x4_t tex23 = vcombine_f32(
+          vget_low_f32(vextq_f32(l3, l3, 1)), vget_high_f32(l4));
+      float* tex = reinterpret_cast<float*>(tex_coords + i);
+      vst1q_f32(tex, vmulq_f32(tex01, scale));
+      vst1q_f32(tex + 4, vmulq_f32(tex23, scale));
+    }
+
+    if(colors) {
+      uint32x4_t c = vdupq_n_u32(0);
+      c = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_f32(l0), 2), c, 0);
+      c = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_f32(l1), 3), c, 1);
+      c = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_f32(l3), 0), c, 2);
+      c = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_f32(l4), 1), c, 3);
+      vst1q_u32(reinterpret_cast<uint32_t*>(colors + i), SwizzleColorsNEON(c));
+    }
+  }
+
+  if(colors) {
+    UnpremultiplyColors(colors, i);
+  }
+
+  SkiaKernels::ConvertVerticesScalar(
+      vertices + i, count - i, translation, tex_scale, positions + i,
+      tex_coords ? tex_coords + i : nullptr, colors ? colors + i : nullptr);
+}
+
+// x / 255 for x <= 255 * 255, as in PremultiplyWordsSSE2().
+static inline uint8x8_t PremultiplyNEON(uint8x8_t c, uint8x8_t a)
+{
+  uint16x8_t x = vmull_u8(c, a);
+  x = vshrq_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+  return vmovn_u16(x);
+}
+
+static bool ConvertTgaPixelsNEON(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest)
+{
+  uint8x8_t alpha_and = vdup_n_u8(255);
+
+  // The structure loads split the pixels into channel planes.
+  int i = 0;
+  if(source_bytes == 4) {
+    for(; i + 8 <= count; i += 8) {
+      uint8x8x4_t bgra = vld4_u8(source + i * 4);
+      const uint8x8_t a = bgra.val[3];
+      alpha_and = vand_u8(alpha_and, a);
+
+      const uint8x8_t b = PremultiplyNEON(bgra.val[0], a);
+      const uint8x8_t r = PremultiplyNEON(bgra.val[2], a);
+
+      uint8x8x4_t pixels;
+      pixels.val[0] = dest_rgba ? r : b;
+      pixels.val[1] = PremultiplyNEON(bgra.val[1], a);
+      pixels.val[2] = dest_rgba ? b : r;
+      pixels.val[3] = a;
+      vst4_u8(dest + i * 4, pixels);
+    }
+  } else {
+    for(; i + 8 <= count; i += 8) {
+      uint8x8x3_t bgr = vld3_u8(source + i * 3);
+
+      uint8x8x4_t pixels;
+      pixels.val[0] = dest_rgba ? bgr.val[2] : bgr.val[0];
+      pixels.val[1] = bgr.val[1];
+      pixels.val[2] = dest_rgba ? bgr.val[0] : bgr.val[2];
+      pixels.val[3] = vdup_n_u8(255);
+      vst4_u8(dest + i * 4, pixels);
+    }
+  }
+
+  const bool opaque =
+      vget_lane_u64(vreinterpret_u64_u8(alpha_and), 0) == ~uint64_t(0);
+
+  return SkiaKernels::ConvertTgaPixelsScalar(
+             source + i * source_bytes, source_bytes, count - i, dest_rgba,
+             dest + i * 4)
+      && opaque;
+}
+
+#endif  // SKIAKERNELS_NEON
+
+static bool IsSupported(SkiaKernels::InstructionSet instruction_set)
+{
+  using SkiaKernels::InstructionSet;
+
+  switch(instruction_set) {
+    case InstructionSet::Scalar:
+      return true;
+#ifdef SKIAKERNELS_X86
+    case InstructionSet::SSE2:
+      return HasSSE2();
+    case InstructionSet::AVX2:
+      return HasAVX2();
+#endif
+#ifdef SKIAKERNELS_NEON
+    case InstructionSet::NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+static ConvertVerticesFunction GetConvertVertices(
+    SkiaKernels::InstructionSet instruction_set)
+{
+  using SkiaKernels::InstructionSet;
+
+  switch(instruction_set) {
+#ifdef SKIAKERNELS_X86
+    case InstructionSet::SSE2:
+      return ConvertVerticesSSE2;
+    case InstructionSet::AVX2:
+      return ConvertVerticesAVX2;
+#endif
+#ifdef SKIAKERNELS_NEON
+    case InstructionSet::NEON:
+      return ConvertVerticesNEON;
+#endif
+    default:
+      return SkiaKernels::ConvertVerticesScalar;
+  }
+}
+
+static ConvertTgaPixelsFunction GetConvertTgaPixels(
+    SkiaKernels::InstructionSet instruction_set)
+{
+  using SkiaKernels::InstructionSet;
+
+  switch(instruction_set) {
+#ifdef SKIAKERNELS_X86
+    case InstructionSet::SSE2:
+      return ConvertTgaPixelsSSE2;
+    case InstructionSet::AVX2:
+      return ConvertTgaPixelsAVX2;
+#endif
+#ifdef SKIAKERNELS_NEON
+    case InstructionSet::NEON:
+      return ConvertTgaPixelsNEON;
+#endif
+    default:
+      return SkiaKernels::ConvertTgaPixelsScalar;
+  }
+}
+
+SkiaKernels::InstructionSet SkiaKernels::GetInstructionSet()
+{
+  static const InstructionSet instruction_set = []() {
+    for(InstructionSet candidate :
+        {InstructionSet::AVX2, InstructionSet::NEON, InstructionSet::SSE2}) {
+      if(IsSupported(candidate)) {
+        return candidate;
+      }
+    }
+    return InstructionSet::Scalar;
+  }();
+
+  return instruction_set;
+}
+
+void SkiaKernels::ConvertVertices(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors)
+{
+  static const ConvertVerticesFunction function =
+      GetConvertVertices(GetInstructionSet());
+  function(
+      vertices, count, translation, tex_scale, positions, tex_coords, colors);
+}
+
+bool SkiaKernels::ConvertVerticesWith(
+    InstructionSet instruction_set,
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors)
+{
+  if(!IsSupported(instruction_set)) {
+    return false;
+  }
+
+  GetConvertVertices(instruction_set)(
+      vertices, count, translation, tex_scale, positions, tex_coords, colors);
+  return true;
+}
+
+bool SkiaKernels::ConvertTgaPixels(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest)
+{
+  static const ConvertTgaPixelsFunction function =
+      GetConvertTgaPixels(GetInstructionSet());
+  return function(source, source_bytes, count, dest_rgba, dest);
+}
+
+bool SkiaKernels::ConvertTgaPixelsWith(
+    InstructionSet instruction_set,
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest,
+    bool* opaque)
+{
+  if(!IsSupported(instruction_set)) {
+    return false;
+  }
+
+  *opaque = GetConvertTgaPixels(instruction_set)(
+      source, source_bytes, count, dest_rgba, dest);
+  return true;
+}
@@ -0,0 +1,129 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#ifndef SKIARMLBACKEND_SKIAKERNELS_H
+#define SKIARMLBACKEND_SKIAKERNELS_H
+
+#include <RmlUi/Core/Types.h>
+#include <RmlUi/Core/Vertex.h>
+
+#include "include/core/SkColor.h"
+#include "include/core/SkPoint.h"
+
+// Data conversion kernels of the render path. Each kernel has a scalar
+// version and SIMD versions, the fastest one supported by the CPU is selected
+// at runtime.
+namespace SkiaKernels
+{
+
+enum class InstructionSet
+{
+  Scalar,
+  SSE2,
+  AVX2,
+  NEON,
+};
+
+// Returns the instruction set used by the dispatched kernels.
+InstructionSet GetInstructionSet();
+
+// Converts a premultiplied RmlUi colour to an SkColor, which Skia expects
+// unpremultiplied in paints, SkVertices and atlas colours.
+SkColor ConvertColor(Rml::ColourbPremultiplied color);
+
+// Converts interleaved RmlUi vertices to the Skia arrays: positions are offset
+// by 'translation', texture coordinates are scaled by 'tex_scale', and colours
+// are converted by ConvertColor(). 'tex_coords' and 'colors' may be null to
+// skip them.
+void ConvertVertices(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors);
+
+// Reference implementation of ConvertVertices(), used for the tail of the
+// SIMD kernels and on CPUs without SIMD support.
+void ConvertVerticesScalar(
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors);
+
+// Runs the kernel of the given instruction set, returns false if it is not
+// supported by the CPU or the build. For tests and benchmarks.
+bool ConvertVerticesWith(
+    InstructionSet instruction_set,
+    const Rml::Vertex* vertices,
+    int count,
+    Rml::Vector2f translation,
+    Rml::Vector2f tex_scale,
+    SkPoint* positions,
+    SkPoint* tex_coords,
+    SkColor* colors);
+
+// Converts 'count' TGA pixels, BGR if 'source_bytes' is 3 or BGRA if it is 4,
+// to premultiplied pixels of 4 bytes, in RGBA order if 'dest_rgba' and BGRA
+// order otherwise.
+// @return True if all pixels are opaque.
+bool ConvertTgaPixels(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest);
+
+// Reference implementation of ConvertTgaPixels().
+bool ConvertTgaPixelsScalar(
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest);
+
+// Runs the kernel of the given instruction set like ConvertVerticesWith(),
+// 'opaque' receives the result of the kernel.
+bool ConvertTgaPixelsWith(
+    InstructionSet instruction_set,
+    const Rml::byte* source,
+    int source_bytes,
+    int count,
+    bool dest_rgba,
+    Rml::byte* dest,
+    bool* opaque);
+
+}  // namespace SkiaKernels
+
+#endif  // SKIARMLBACKEND_SKIAKERNELS_H
@@ -0,0 +1,111 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+
+#include "SkiaPresentThread.h"
+
+SkiaPresentThread::SkiaPresentThread(
+    int capacity, uint64_t last_frame, PresentFunction present_function)
+    : capacity {capacity}
+    , queue {static_cast<size_t>(capacity)}
+    , present_function {std::move(present_function)}
+    , presented_frame {last_frame}
+    , thread {[this]() { ThreadLoop(); }}
+{
+}
+
+SkiaPresentThread::~SkiaPresentThread()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  submit_condition.notify_one();
+
+  thread.join();
+}
+
+void SkiaPresentThread::Submit(uint64_t frame, int buffer)
+{
+  // The queue holds the frames after the one being presented.
+  if(frame > static_cast<uint64_t>(capacity)) {
+    WaitForFrame(frame - capacity);
+  }
+
+  RMLUI_VERIFY(queue.Push({frame, buffer}));
+
+  // Taking the lock orders the push before the wait of the thread.
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+  }
+  submit_condition.notify_one();
+}
+
+uint64_t SkiaPresentThread::GetPresentedFrame() const
+{
+  return presented_frame.load(std::memory_order_acquire);
+}
+
+void SkiaPresentThread::WaitForFrame(uint64_t frame)
+{
+  if(GetPresentedFrame() >= frame) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  present_condition.wait(
+      lock, [&]() { return GetPresentedFrame() >= frame; });
+}
+
+void SkiaPresentThread::ThreadLoop()
+{
+  for(;;) {
+    QueuedFrame queued;
+
+    if(queue.Pop(queued)) {
+      present_function(queued.frame, queued.buffer);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        presented_frame.store(queued.frame, std::memory_order_release);
+      }
+      present_condition.notify_all();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    submit_condition.wait(
+        lock, [this]() { return stopping || !queue.IsEmpty(); });
+
+    if(stopping && queue.IsEmpty()) {
+      return;
+    }
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+
+#ifndef SKIARMLBACKEND_SKIAPRESENTTHREAD_H
+#define SKIARMLBACKEND_SKIAPRESENTTHREAD_H
+
+#include "SkiaSpscQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Thread presenting finished frames in submission order. The render thread
+// hands the frames over through a lock-free queue, the present thread sleeps
+// while the queue is empty.
+class SkiaPresentThread
+{
+public:
+  // Called on the present thread with the index of the frame and its buffer.
+  using PresentFunction = std::function<void(uint64_t frame, int buffer)>;
+
+  // Queues up to 'capacity' frames. Frames up to 'last_frame' count as
+  // presented.
+  SkiaPresentThread(
+      int capacity, uint64_t last_frame, PresentFunction present_function);
+  // Presents the queued frames and stops the thread.
+  ~SkiaPresentThread();
+
+  SkiaPresentThread(const SkiaPresentThread&) = delete;
+  SkiaPresentThread& operator=(const SkiaPresentThread&) = delete;
+
+  // Queues the next frame, 'frame' counts up by one from 'last_frame'. Waits
+  // while the queue is full. Render thread only.
+  void Submit(uint64_t frame, int buffer);
+
+  // The fence: the index of the last presented frame.
+  uint64_t GetPresentedFrame() const;
+  // Waits until 'frame' is presented.
+  void WaitForFrame(uint64_t frame);
+
+private:
+  struct QueuedFrame
+  {
+    uint64_t frame;
+    int buffer;
+  };
+
+  void ThreadLoop();
+
+  const int capacity;
+  SkiaSpscQueue<QueuedFrame> queue;
+  PresentFunction present_function;
+
+  std::atomic<uint64_t> presented_frame;
+
+  // Only to sleep and wake up, the frames pass through the queue.
+  std::mutex mutex;
+  std::condition_variable submit_condition;
+  std::condition_variable present_condition;
+  bool stopping = false;
+
+  std::thread thread;
+};
+
+#endif  // SKIARMLBACKEND_SKIAPRESENTTHREAD_H
@@ -30,26 +30,86 @@
 
 #include "SkiaRenderInterface.h"
 
+#include "SkiaKernels.h"
+#include "SkiaTextureLoader.h"
+
 #include <RmlUi/Core/Core.h>
-#include <RmlUi/Core/FileInterface.h>
 #include <RmlUi/Core/Types.h>
 
+#include "include/core/SkBBHFactory.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkBlender.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
 #include "include/core/SkImage.h"
+#include "include/core/SkMesh.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
 #include "include/core/SkPixmap.h"
+#include "include/core/SkRSXform.h"
+#include "include/core/SkRegion.h"
 #include "include/core/SkSurface.h"
+#include "include/core/SkSwizzle.h"
 #include "include/core/SkVertices.h"
 
 // #include "FileUtil.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <vector>
 
-static constexpr SkColorType COLOR_TYPE = SkColorType::kRGBA_8888_SkColorType;
 static constexpr SkAlphaType ALPHA_TYPE = SkAlphaType::kPremul_SkAlphaType;
 static constexpr SkColor BACKGROUND_COLOR = SK_ColorBLACK;
 
+// SkVertices indices are 16-bit.
+static constexpr size_t MAX_BATCH_VERTICES = 65536;
+
+// The mesh path reads Rml::Vertex as is, the colour is premultiplied like the
+// mesh output colour. The texture coordinates are scaled to the pixel space of
+// the bound texture.
+static const char* MESH_VERTEX_SHADER = R"(
+uniform float2 tex_scale;
+
+Varyings main(const Attributes attributes)
+{
+  Varyings varyings;
+  varyings.position = attributes.position;
+  varyings.color = attributes.color;
+  varyings.tex_coord = attributes.tex_coord * tex_scale;
+  return varyings;
+}
+)";
+
+static const char* MESH_FRAGMENT_SHADER = R"(
+float2 main(const Varyings varyings, out half4 color)
+{
+  color = varyings.color;
+  return varyings.tex_coord;
+}
+)";
+
+// Larger geometry is drawn from its compiled vertices, merging it would cost
+// more than the saved draw call.
+static constexpr size_t MAX_MERGE_VERTICES = 1024;
+
+// 64-bit FNV-1a, hashes the command stream of deferred frames.
+static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+// Damage regions made of more rectangles are redrawn as their bounds.
+static constexpr int MAX_DAMAGE_RECTS = 16;
+
+// Tiles of the threaded playback, small enough to balance the load between
+// the threads.
+static constexpr int RASTER_TILE_SIZE = 256;
+
+// Relative difference of the horizontal and vertical scale of a quad up to
+// which it is drawn as an atlas sprite.
+static constexpr float MAX_ATLAS_SCALE_ERROR = 1e-4f;
+
 // static void SetRenderClipRect(SDL_Renderer* renderer, const SDL_Rect* rect)
 // {
 // #if SDL_MAJOR_VERSION >= 3
@@ -67,9 +127,36 @@ static constexpr SkColor BACKGROUND_COLOR = SK_ColorBLACK;
 // #endif
 // }
 
-SkiaRenderInterface::SkiaRenderInterface(SkCanvas* canvas)
+static SkColorType MakeTextureColorType(SkColorType color_type)
+{
+  switch(color_type) {
+    case SkColorType::kRGBA_8888_SkColorType:
+    case SkColorType::kBGRA_8888_SkColorType:
+      return color_type;
+    default:
+      return SkColorType::kN32_SkColorType;
+  }
+}
+
+static SkColorType MakeOpaqueTextureColorType(SkColorType color_type)
+{
+  switch(color_type) {
+    case SkColorType::kRGB_565_SkColorType:
+    case SkColorType::kGray_8_SkColorType:
+      return color_type;
+    default:
+      return MakeTextureColorType(color_type);
+  }
+}
+
+SkiaRenderInterface::SkiaRenderInterface(
+    SkCanvas* canvas, SkColorType color_type)
     : canvas_ {canvas}
+    , texture_color_type {MakeTextureColorType(color_type)}
+    , opaque_texture_color_type {MakeOpaqueTextureColorType(color_type)}
+    , draw_canvas {canvas}
 {
+  UpdateCullRect();
 }
 
 SkCanvas* SkiaRenderInterface::getCanvas()
@@ -77,301 +164,1978 @@ SkCanvas* SkiaRenderInterface::getCanvas()
   return canvas_;
 }
 
-void SkiaRenderInterface::BeginFrame()
+void SkiaRenderInterface::SetCanvas(SkCanvas* canvas)
 {
-  canvas_->clear(BACKGROUND_COLOR);
+  RMLUI_ASSERT(!frame_deferred && pending_draws == 0);
+
+  if(canvas != canvas_) {
+    canvas_ = canvas;
+    draw_canvas = canvas;
+    // The new canvas does not hold the previous frame.
+    previous_frame_valid = false;
+    UpdateCullRect();
+  }
 }
 
-void SkiaRenderInterface::EndFrame() {}
+SkColorType SkiaRenderInterface::GetTextureColorType() const
+{
+  return texture_color_type;
+}
 
-Rml::CompiledGeometryHandle SkiaRenderInterface::CompileGeometry(
-    Rml::Span<const Rml::Vertex> vertices, Rml::Span<const int> indices)
+SkColorType SkiaRenderInterface::GetOpaqueTextureColorType() const
 {
-  auto* data = new GeometryView {std::move(vertices), std::move(indices)};
-  return reinterpret_cast<Rml::CompiledGeometryHandle>(data);
+  return opaque_texture_color_type;
 }
 
-void SkiaRenderInterface::RenderGeometry(
-    Rml::CompiledGeometryHandle handle,
-    Rml::Vector2f translation,
-    Rml::TextureHandle texture)
+void SkiaRenderInterface::BeginFrame()
 {
-  const GeometryView* geometry = reinterpret_cast<GeometryView*>(handle);
-  const Rml::Vertex* vertices = geometry->vertices.data();
-  const size_t vertSize = geometry->vertices.size();
-  const int* indices = geometry->indices.data();
-  const size_t indiSize = geometry->indices.size();
+  FlushPending();
+  ResetScissor();
+  scissor_region_enabled = false;
+
+  frame_arena.Reset();
+  pending = nullptr;
+  pending_capacity = 0;
+
+  commands = nullptr;
+  command_capacity = 0;
+  command_count = 0;
+  played_commands = 0;
+  command_hash = FNV_OFFSET_BASIS;
+  commands_complete = true;
+
+  frame_stats = {};
+  ++frame_number;
+  UpdateCullRect();
+
+  if(texture_loader || !loading_textures.empty()) {
+    SwapLoadedTextures();
+  }
 
-  auto* skPaint = reinterpret_cast<SkPaint*>(texture);
-  SkShader* skShader = skPaint ? skPaint->getShader() : nullptr;
-  SkImage* skImgage = skShader ? skShader->isAImage(nullptr, nullptr) : nullptr;
+  // Deferred frames clear the canvas when they are presented.
+  frame_deferred =
+      picture_cache_enabled || damage_tracking_enabled || raster_threads;
+  if(!frame_deferred) {
+    canvas_->clear(BACKGROUND_COLOR);
+  }
+}
 
-  auto skPos = std::make_unique<std::vector<SkPoint>>();
-  auto skTex = std::make_unique<std::vector<SkPoint>>();
-  auto skColor = std::make_unique<std::vector<SkColor>>();
+void SkiaRenderInterface::EndFrame()
+{
+  if(frame_deferred) {
+    PresentDeferredFrame();
+    frame_deferred = false;
+  } else {
+    previous_frame_valid = false;
+  }
 
-  skPos->reserve(vertSize);
-  skColor->reserve(vertSize);
+  FlushPending();
+  ResetScissor();
+  EvictMergedVertices();
 
-  if(skImgage) {
-    skTex->reserve(vertSize);
+  damage_rects.clear();
+  if(damage_tracking_enabled) {
+    for(SkRegion::Iterator it(damage_region); !it.done(); it.next()) {
+      const SkIRect& rect = it.rect();
+      damage_rects.push_back(Rml::Rectanglei::FromCorners(
+          {rect.fLeft, rect.fTop}, {rect.fRight, rect.fBottom}));
+    }
+  } else {
+    const SkISize size = canvas_->getBaseLayerSize();
+    damage_rects.push_back(Rml::Rectanglei::FromPositionSize(
+        {0, 0}, {size.width(), size.height()}));
   }
 
-  const int imgWidth = skImgage ? skImgage->width() : 1;
-  const int imgHeight = skImgage ? skImgage->height() : 1;
+  frame_stats.arena_block_allocations = frame_arena.GetBlockAllocations();
+
+  if(texture_budget > 0) {
+    EvictTextures();
+  }
+}
 
-  for(size_t i = 0; i < vertSize; ++i) {
-    const Rml::Vertex& vert = vertices[i];
-    skPos->push_back(SkPoint::Make(vert.position.x, vert.position.y));
+void SkiaRenderInterface::SetBatchingEnabled(bool enable)
+{
+  FlushPending();
+  batching_enabled = enable;
+}
 
-    if(skImgage) {
-      SkScalar texX = vert.tex_coord.x * imgWidth;
-      SkScalar texY = vert.tex_coord.y * imgHeight;
-      skTex->push_back(SkPoint::Make(texX, texY));
+bool SkiaRenderInterface::SetGeometryPath(GeometryPath path)
+{
+  FlushPending();
+
+  if(path == GeometryPath::Mesh && !mesh_specification) {
+    using Attribute = SkMeshSpecification::Attribute;
+    using Varying = SkMeshSpecification::Varying;
+
+    const Attribute attributes[] = {
+        {Attribute::Type::kFloat2, offsetof(Rml::Vertex, position),
+         SkString("position")},
+        {Attribute::Type::kUByte4_unorm, offsetof(Rml::Vertex, colour),
+         SkString("color")},
+        {Attribute::Type::kFloat2, offsetof(Rml::Vertex, tex_coord),
+         SkString("tex_coord")},
+    };
+    const Varying varyings[] = {
+        {Varying::Type::kHalf4, SkString("color")},
+        {Varying::Type::kFloat2, SkString("tex_coord")},
+    };
+
+    SkMeshSpecification::Result result = SkMeshSpecification::Make(
+        attributes, sizeof(Rml::Vertex), varyings,
+        SkString(MESH_VERTEX_SHADER), SkString(MESH_FRAGMENT_SHADER));
+
+    if(!result.specification) {
+      Rml::Log::Message(
+          Rml::Log::LT_ERROR, "Skia can not create the mesh specification: %s",
+          result.error.c_str());
+      return false;
     }
 
-    const Rml::ColourbPremultiplied& color = vert.colour;
-    skColor->push_back(
-        SkColorSetARGB(color.alpha, color.red, color.green, color.blue));
+    mesh_specification = std::move(result.specification);
   }
 
-  std::vector<uint16_t> skIndices;
-  skIndices.reserve(indiSize);
+  geometry_path = path;
+  return true;
+}
+
+SkiaRenderInterface::GeometryPath SkiaRenderInterface::GetGeometryPath() const
+{
+  return geometry_path;
+}
+
+void SkiaRenderInterface::SetPictureCacheEnabled(bool enable)
+{
+  if(enable != picture_cache_enabled) {
+    picture_cache_enabled = enable;
+    picture_cache_stats = {};
+    cached_picture.reset();
+  }
+}
 
-  for(size_t i = 0; i < indiSize; ++i) {
-    skIndices.push_back(static_cast<uint16_t>(indices[i]));
+void SkiaRenderInterface::SetDamageTrackingEnabled(bool enable)
+{
+  if(enable != damage_tracking_enabled) {
+    damage_tracking_enabled = enable;
+    // The first frame is drawn in full.
+    previous_frame_valid = false;
   }
+}
 
-  sk_sp<SkVertices> skVertices = SkVertices::MakeCopy(
-      SkVertices::kTriangles_VertexMode, static_cast<int>(vertSize),
-      skPos->data(), skTex->data(), skColor->data(), static_cast<int>(indiSize),
-      skIndices.data());
+const Rml::Vector<Rml::Rectanglei>& SkiaRenderInterface::GetDamageRects() const
+{
+  return damage_rects;
+}
 
-  {
-    SkAutoCanvasRestore acr(canvas_, true);
-    canvas_->translate(translation.x, translation.y);
+void SkiaRenderInterface::SetRasterThreadCount(int count)
+{
+  if(count <= 1) {
+    raster_threads.reset();
+  } else if(!raster_threads || raster_threads->GetThreadCount() != count) {
+    raster_threads = Rml::MakeUnique<SkiaThreadPool>(count);
+  }
+}
 
-    // canvas_->clipRect(SkRect::MakeLTRB(drawCmd->ClipRect.x, drawCmd->ClipRect.y,
-    //                                   drawCmd->ClipRect.z, drawCmd->ClipRect.w));
+void SkiaRenderInterface::SetTextureLoadThreadCount(int count)
+{
+  if(count <= 0) {
+    // Finishes the queued loads, they are swapped in as usual.
+    texture_loader.reset();
+  } else if(!texture_loader || texture_loader->GetThreadCount() != count) {
+    texture_loader.reset();
+    texture_loader = Rml::MakeUnique<SkiaTaskQueue>(count);
+  }
+}
 
-    // src + dst == (srcRGB * 1) + (dstRGB * (1 - srcA))
-    // src + dst == (srcA * 1) + (dstA * (1 - srcA))
-    // kModulate
-    // kSrc, kSrcIn
-    // kDstIn, kDstOut, kDstATop, kXor, kDifference, kExclusion
+void SkiaRenderInterface::SetTextureLoadedCallback(
+    TextureLoadedCallback callback)
+{
+  std::lock_guard<std::mutex> lock(loaded_mutex);
+  texture_loaded_callback = std::move(callback);
+}
 
-    if(skPaint) {
-      canvas_->drawVertices(skVertices, SkBlendMode::kModulate, *skPaint);
-    } else {
-      canvas_->drawVertices(skVertices, SkBlendMode::kDst, SkPaint {});
-    }
+void SkiaRenderInterface::SetTextureBudget(size_t bytes)
+{
+  texture_budget = bytes;
+}
+
+void SkiaRenderInterface::SetTextureMemory(SkiaTextureMemory* texture_memory)
+{
+  this->texture_memory = texture_memory;
+}
+
+SkiaTextureMemory* SkiaRenderInterface::GetTextureMemory() const
+{
+  return texture_memory;
+}
+
+void SkiaRenderInterface::SetDitheringEnabled(bool enable)
+{
+  if(enable != dithering_enabled) {
+    dithering_enabled = enable;
+    // Every pixel may change, the next frame is drawn in full.
+    cached_picture.reset();
+    previous_frame_valid = false;
   }
+}
 
+void SkiaRenderInterface::SetGlyphAtlasEnabled(bool enable)
+{
+  glyph_atlas_enabled = enable;
+}
 
-  // SkImageInfo skImgInfo = canvas_->imageInfo();
-  // std::vector<unsigned char> frameBuf(skImgInfo.computeMinByteSize());
-  // canvas_->readPixels(
-  //     skImgInfo, frameBuf.data(), skImgInfo.minRowBytes(), 0, 0);
-  // std::string fileOutTest1 = std::to_string(handle) + "__RmlUi_draw.ppm";
-  // writePpmFile(
-  //     frameBuf.data(), skImgInfo.width(), skImgInfo.height(), skImgInfo.bytesPerPixel(),
-  //     fileOutTest1);
+const SkiaRenderInterface::FrameStats& SkiaRenderInterface::GetFrameStats() const
+{
+  return frame_stats;
 }
 
-void SkiaRenderInterface::ReleaseGeometry(Rml::CompiledGeometryHandle geometry)
+const SkiaRenderInterface::PictureCacheStats&
+SkiaRenderInterface::GetPictureCacheStats() const
+{
+  return picture_cache_stats;
+}
+
+const SkiaRenderInterface::TextureStats&
+SkiaRenderInterface::GetTextureStats() const
 {
-  delete reinterpret_cast<GeometryView*>(geometry);
+  return texture_stats;
 }
 
-// Set to byte packing, or the compiler will expand our struct, which means it
-// won't read correctly from file.
-#pragma pack(push, 1)
-struct TGAHeader
+double SkiaRenderInterface::TextureStats::GetCacheHitRate() const
 {
-  char idLength;
-  char colourMapType;
-  char dataType;
-  short int colourMapOrigin;
-  short int colourMapLength;
-  char colourMapDepth;
-  short int xOrigin;
-  short int yOrigin;
-  short int width;
-  short int height;
-  char bitsPerPixel;
-  char imageDescriptor;
-};
-// Restore packing.
-#pragma pack(pop)
+  const uint64_t draws = cache_hits + cache_misses;
+  return draws > 0 ? static_cast<double>(cache_hits) / draws : 1.0;
+}
 
-static_assert(sizeof(TGAHeader) == 18);
+void SkiaRenderInterface::UpdateCullRect()
+{
+  const SkISize size = canvas_->getBaseLayerSize();
+  cull_rect = SkRect::MakeWH(size.width(), size.height());
 
-Rml::TextureHandle SkiaRenderInterface::LoadTexture(
-    Rml::Vector2i& texture_dimensions, const Rml::String& source)
+  if(scissor_region_enabled && !cull_rect.intersect(rect_scissor)) {
+    cull_rect.setEmpty();
+  }
+}
+
+// The compiled bounds are tested before any conversion work, so geometry
+// scrolled out of view costs next to nothing.
+bool SkiaRenderInterface::IsCulled(
+    const GeometryBatch& batch, Rml::Vector2f translation) const
 {
-  Rml::FileInterface* file_interface = Rml::GetFileInterface();
-  Rml::FileHandle file_handle = file_interface->Open(source);
-  if(!file_handle) {
-    // TODO: Make log message for errors.
-    return false;
+  const SkRect bounds = batch.bounds.makeOffset(translation.x, translation.y);
+  return bounds.fLeft >= cull_rect.fRight || bounds.fRight <= cull_rect.fLeft
+      || bounds.fTop >= cull_rect.fBottom || bounds.fBottom <= cull_rect.fTop;
+}
+
+static SkRect ComputeBounds(Rml::Span<const Rml::Vertex> vertices)
+{
+  if(vertices.empty()) {
+    return SkRect::MakeEmpty();
   }
 
-  file_interface->Seek(file_handle, 0, SEEK_END);
-  size_t buffer_size = file_interface->Tell(file_handle);
-  file_interface->Seek(file_handle, 0, SEEK_SET);
+  const Rml::Vector2f first = vertices[0].position;
+  SkRect bounds = SkRect::MakeLTRB(first.x, first.y, first.x, first.y);
 
-  if(buffer_size <= sizeof(TGAHeader)) {
-    Rml::Log::Message(
-        Rml::Log::LT_ERROR,
-        "Texture file size is smaller than TGAHeader, file is not a valid TGA image.");
-    file_interface->Close(file_handle);
-    return false;
+  for(const Rml::Vertex& vertex : vertices) {
+    bounds.fLeft = Rml::Math::Min(bounds.fLeft, vertex.position.x);
+    bounds.fTop = Rml::Math::Min(bounds.fTop, vertex.position.y);
+    bounds.fRight = Rml::Math::Max(bounds.fRight, vertex.position.x);
+    bounds.fBottom = Rml::Math::Max(bounds.fBottom, vertex.position.y);
   }
 
-  using Rml::byte;
-  Rml::UniquePtr<byte[]> buffer(new byte[buffer_size]);
-  size_t read_cnt =
-      file_interface->Read(buffer.get(), buffer_size, file_handle);
-  file_interface->Close(file_handle);
+  return bounds;
+}
 
-  if(read_cnt < buffer_size) {
-    return false;
+// Texture coordinates spanning [0, 1] map the whole texture to the bounds of
+// a triangle, a smaller span draws a part of a larger texture. 9-slice and
+// tiled geometry map a different part of the texture to each triangle at its
+// own scale, so the largest scale of the triangles is taken.
+static SkISize ComputeTextureDrawSize(
+    Rml::Span<const Rml::Vertex> vertices, Rml::Span<const int> indices)
+{
+  auto drawSize = [](float length, float span) {
+    return span > 0 ? static_cast<int32_t>(std::ceil(length / span)) : 0;
+  };
+  auto span = [](float a, float b, float c) {
+    return Rml::Math::Max(a, Rml::Math::Max(b, c))
+        - Rml::Math::Min(a, Rml::Math::Min(b, c));
+  };
+
+  SkISize size = {0, 0};
+  for(size_t i = 0; i + 3 <= indices.size(); i += 3) {
+    const Rml::Vertex& v0 = vertices[indices[i]];
+    const Rml::Vertex& v1 = vertices[indices[i + 1]];
+    const Rml::Vertex& v2 = vertices[indices[i + 2]];
+
+    size.fWidth = Rml::Math::Max(
+        size.fWidth,
+        drawSize(
+            span(v0.position.x, v1.position.x, v2.position.x),
+            span(v0.tex_coord.x, v1.tex_coord.x, v2.tex_coord.x)));
+    size.fHeight = Rml::Math::Max(
+        size.fHeight,
+        drawSize(
+            span(v0.position.y, v1.position.y, v2.position.y),
+            span(v0.tex_coord.y, v1.tex_coord.y, v2.tex_coord.y)));
   }
 
-  auto* header = reinterpret_cast<TGAHeader*>(buffer.get());
+  return size;
+}
 
-  if(header->dataType != 2) {
-    Rml::Log::Message(
-        Rml::Log::LT_ERROR, "Only 24/32bit uncompressed TGAs are supported.");
+Rml::CompiledGeometryHandle SkiaRenderInterface::CompileGeometry(
+    Rml::Span<const Rml::Vertex> vertices, Rml::Span<const int> indices)
+{
+  auto* geometry = new CompiledGeometry {};
+  geometry->id = next_resource_id++;
+  geometry->bounds = ComputeBounds(vertices);
+  geometry->texture_draw_size = ComputeTextureDrawSize(vertices, indices);
+
+  if(vertices.size() <= MAX_BATCH_VERTICES) {
+    geometry->batches.emplace_back();
+    GeometryBatch& batch = geometry->batches.back();
+    batch.vertices = vertices;
+    batch.indices.reserve(indices.size());
+
+    for(int index : indices) {
+      RMLUI_ASSERT(index >= 0 && static_cast<size_t>(index) < vertices.size());
+      batch.indices.push_back(static_cast<uint16_t>(index));
+    }
+  } else {
+    SplitGeometry(vertices, indices, geometry->batches);
+  }
+
+  // The SkVertices are built by the first draw that needs them, textured
+  // batches and quads drawn as rectangles never build the untextured ones.
+  for(GeometryBatch& batch : geometry->batches) {
+    batch.id = next_resource_id++;
+    batch.bounds = ComputeBounds(batch.vertices);
+    ClassifyBatch(batch);
+
+    if(geometry_path == GeometryPath::Mesh) {
+      MakeMeshBuffers(batch);
+    }
+  }
+
+  return reinterpret_cast<Rml::CompiledGeometryHandle>(geometry);
+}
+
+void SkiaRenderInterface::SplitGeometry(
+    Rml::Span<const Rml::Vertex> vertices,
+    Rml::Span<const int> indices,
+    Rml::Vector<GeometryBatch>& batches)
+{
+  // Index of each source vertex in the current batch, or -1 if the vertex is
+  // not yet in the batch.
+  Rml::Vector<int> remap(vertices.size(), -1);
+  Rml::Vector<int> batch_sources;
+
+  auto startBatch = [&]() {
+    for(int source : batch_sources) {
+      remap[source] = -1;
+    }
+    batch_sources.clear();
+    batches.emplace_back();
+  };
+
+  startBatch();
+
+  for(size_t i = 0; i + 3 <= indices.size(); i += 3) {
+    // A triangle adds at most three vertices, start a new batch if they might
+    // not fit in the 16-bit index range.
+    if(batches.back().split_vertices.size() + 3 > MAX_BATCH_VERTICES) {
+      startBatch();
+    }
+
+    GeometryBatch& batch = batches.back();
+
+    for(size_t j = i; j < i + 3; ++j) {
+      const int source = indices[j];
+      RMLUI_ASSERT(source >= 0 && static_cast<size_t>(source) < vertices.size());
+
+      if(remap[source] < 0) {
+        remap[source] = static_cast<int>(batch.split_vertices.size());
+        batch.split_vertices.push_back(vertices[source]);
+        batch_sources.push_back(source);
+      }
+
+      batch.indices.push_back(static_cast<uint16_t>(remap[source]));
+    }
+  }
+
+  for(GeometryBatch& batch : batches) {
+    batch.vertices = batch.split_vertices;
+  }
+}
+
+// Texture coordinates of RmlUi are normalized, Skia takes them in the pixel
+// space of the image.
+static Rml::Vector2f GetTexScale(const SkImage* image)
+{
+  if(!image) {
+    return {1, 1};
+  }
+  return {static_cast<float>(image->width()), static_cast<float>(image->height())};
+}
+
+const SkPaint* SkiaRenderInterface::GetTexturePaint(Rml::TextureHandle texture)
+{
+  auto* textureData = reinterpret_cast<const TextureData*>(texture);
+  return textureData ? &textureData->paint : nullptr;
+}
+
+const SkPaint& SkiaRenderInterface::GetDrawPaint(const SkPaint* paint)
+{
+  if(!dithering_enabled) {
+    return paint ? *paint : default_paint;
+  }
+
+  dither_paint = paint ? *paint : default_paint;
+  dither_paint.setDither(true);
+  return dither_paint;
+}
+
+// The paint is kept, so the draws of every frame set its colour instead of
+// copying a paint.
+const SkPaint& SkiaRenderInterface::GetColorPaint(SkColor color)
+{
+  color_paint.setDither(dithering_enabled);
+  color_paint.setColor(color);
+  return color_paint;
+}
+
+// Makes a quad from 4 vertices and the 6 indices of its two triangles if they
+// form an axis-aligned rectangle with one colour, and the texture coordinates
+// are axis-aligned too.
+static bool MakeQuad(
+    const Rml::Vertex* vertices,
+    const uint16_t* indices,
+    int base,
+    SkRect& rect,
+    SkRect& tex_rect)
+{
+  int uses[4] = {};
+
+  for(int t = 0; t < 6; t += 3) {
+    const int a = indices[t] - base;
+    const int b = indices[t + 1] - base;
+    const int c = indices[t + 2] - base;
+    if(a < 0 || a > 3 || b < 0 || b > 3 || c < 0 || c > 3 || a == b || b == c
+       || a == c) {
+      return false;
+    }
+    ++uses[a];
+    ++uses[b];
+    ++uses[c];
+  }
+
+  float minX = vertices[0].position.x;
+  float minY = vertices[0].position.y;
+  float maxX = minX;
+  float maxY = minY;
+
+  for(int i = 1; i < 4; ++i) {
+    if(vertices[i].colour != vertices[0].colour) {
+      return false;
+    }
+    minX = Rml::Math::Min(minX, vertices[i].position.x);
+    minY = Rml::Math::Min(minY, vertices[i].position.y);
+    maxX = Rml::Math::Max(maxX, vertices[i].position.x);
+    maxY = Rml::Math::Max(maxY, vertices[i].position.y);
+  }
+
+  if(minX == maxX || minY == maxY) {
     return false;
   }
 
-  int color_mode = header->bitsPerPixel / 8;
+  // Every vertex is another corner, and the two triangles share the corners
+  // of one diagonal.
+  int corners[4] = {};
+  int cornerMask = 0;
+  int shared = 0;
 
-  // Ensure we have at least 3 colors.
-  if(color_mode < 3) {
-    Rml::Log::Message(
-        Rml::Log::LT_ERROR, "Only 24 and 32bit textures are supported.");
+  for(int i = 0; i < 4; ++i) {
+    const Rml::Vector2f p = vertices[i].position;
+    if((p.x != minX && p.x != maxX) || (p.y != minY && p.y != maxY)) {
+      return false;
+    }
+    corners[i] = (p.x == maxX ? 1 : 0) | (p.y == maxY ? 2 : 0);
+    cornerMask |= 1 << corners[i];
+
+    if(uses[i] == 2) {
+      shared ^= corners[i];
+    } else if(uses[i] != 1) {
+      return false;
+    }
+  }
+
+  if(cornerMask != 0xF || shared != 3) {
     return false;
   }
 
-  short int& width = header->width;
-  short int& height = header->height;
+  // The texture coordinates change along the matching axis only.
+  float texX[2] = {};
+  float texY[2] = {};
 
-  // We always make 32bit textures.
-  SkImageInfo skImgInfo =
-      SkImageInfo::Make(width, height, COLOR_TYPE, ALPHA_TYPE);
+  for(int i = 0; i < 4; ++i) {
+    texX[corners[i] & 1] = vertices[i].tex_coord.x;
+    texY[corners[i] >> 1] = vertices[i].tex_coord.y;
+  }
 
-  SkBitmap skBitmap;
-  skBitmap.allocPixels(skImgInfo);
+  for(int i = 0; i < 4; ++i) {
+    const Rml::Vector2f t = vertices[i].tex_coord;
+    if(t.x != texX[corners[i] & 1] || t.y != texY[corners[i] >> 1]) {
+      return false;
+    }
+  }
 
-  byte* image_dest = reinterpret_cast<byte*>(skBitmap.getPixels());
-  if(!image_dest) {
-    return 0;
+  if(texX[0] > texX[1] || texY[0] > texY[1]) {
+    return false;
   }
 
-  const byte* image_src = buffer.get() + sizeof(TGAHeader);
+  rect = SkRect::MakeLTRB(minX, minY, maxX, maxY);
+  tex_rect = SkRect::MakeLTRB(texX[0], texY[0], texX[1], texY[1]);
+  return true;
+}
 
-  // Targa is BGR, swap to RGB, flip Y axis, and convert to premultiplied alpha.
-  for(long y = 0; y < height; ++y) {
-    long read_index = y * width * color_mode;
-    long write_index = ((header->imageDescriptor & 32) != 0)
-        ? read_index
-        : (height - y - 1) * width * 4;
+void SkiaRenderInterface::ClassifyBatch(GeometryBatch& batch)
+{
+  const Rml::Vertex* vertices = batch.vertices.data();
+  const size_t vertSize = batch.vertices.size();
+  const size_t indiSize = batch.indices.size();
 
-    for(long x = 0; x < width; ++x) {
-      image_dest[write_index] = image_src[read_index + 2];
-      image_dest[write_index + 1] = image_src[read_index + 1];
-      image_dest[write_index + 2] = image_src[read_index];
+  if(vertSize == 0) {
+    return;
+  }
 
-      if(color_mode == 4) {
-        const byte alpha = image_src[read_index + 3];
+  batch.uniform_color = true;
+  batch.color = SkiaKernels::ConvertColor(vertices[0].colour);
 
-        for(size_t j = 0; j < 3; j++) {
-          image_dest[write_index + j] =
-              byte((image_dest[write_index + j] * alpha) / 255);
-        }
+  for(size_t i = 1; i < vertSize; ++i) {
+    if(vertices[i].colour != vertices[0].colour) {
+      batch.uniform_color = false;
+      break;
+    }
+  }
 
-        image_dest[write_index + 3] = alpha;
-      } else {
-        image_dest[write_index + 3] = 255;
-      }
+  // RmlUi generates quads as 4 vertices and 6 indices each.
+  if(vertSize % 4 != 0 || indiSize != vertSize / 4 * 6) {
+    return;
+  }
 
-      write_index += 4;
-      read_index += color_mode;
+  const size_t quadCount = vertSize / 4;
+  batch.quads.reserve(quadCount);
+
+  for(size_t q = 0; q < quadCount; ++q) {
+    GeometryQuad quad;
+    if(!MakeQuad(
+           vertices + q * 4, batch.indices.data() + q * 6,
+           static_cast<int>(q * 4), quad.rect, quad.tex_rect)) {
+      batch.quads.clear();
+      batch.quads.shrink_to_fit();
+      return;
     }
+
+    quad.color = SkiaKernels::ConvertColor(vertices[q * 4].colour);
+    batch.quads.push_back(quad);
+  }
+}
+
+// Vertices of one colour are drawn with the paint colour, or with the texture
+// alone if the colour is opaque white, so Skia does not interpolate colours.
+bool SkiaRenderInterface::OmitsColors(
+    const GeometryBatch& batch, const SkImage* image)
+{
+  if(!batch.uniform_color) {
+    return false;
   }
+  return !image || batch.color == SK_ColorWHITE;
+}
 
-  texture_dimensions.x = width;
-  texture_dimensions.y = height;
+sk_sp<SkVertices> SkiaRenderInterface::MakeVertices(
+    const GeometryBatch& batch, const SkImage* image)
+{
+  const int vertSize = static_cast<int>(batch.vertices.size());
+  const int indiSize = static_cast<int>(batch.indices.size());
 
-  skBitmap.setImmutable();
+  uint32_t flags = 0;
+  if(!OmitsColors(batch, image)) {
+    flags |= SkVertices::kHasColors_BuilderFlag;
+  }
+  if(image) {
+    flags |= SkVertices::kHasTexCoords_BuilderFlag;
+  }
 
-  if(sk_sp<SkImage> img = skBitmap.asImage()) {
-    sk_sp<SkShader> shader = img->makeShader(SkSamplingOptions {}, SkMatrix {});
-    auto* paint = new SkPaint {};
-    paint->setShader(shader);
+  // The builder owns the only copy of the converted data, the vertices are
+  // written straight into it.
+  SkVertices::Builder builder(
+      SkVertices::kTriangles_VertexMode, vertSize, indiSize, flags);
+  if(!builder.isValid()) {
+    return nullptr;
+  }
 
-    // {
-    //     std::vector<unsigned char> frameBuf(skImgInfo.computeMinByteSize());
-    //     img->readPixels(skImgInfo, frameBuf.data(), skImgInfo.minRowBytes(), 0, 0);
-    //     std::string fileOutTest1 = std::to_string(reinterpret_cast<Rml::TextureHandle>(paint)) + "__RmlUi_draw.ppm";
-    //     writePpmFile(
-    //         frameBuf.data(), skImgInfo.width(), skImgInfo.height(), skImgInfo.bytesPerPixel(),
-    //         fileOutTest1);
-    // }
+  SkiaKernels::ConvertVertices(
+      batch.vertices.data(), vertSize, {0, 0}, GetTexScale(image),
+      builder.positions(), builder.texCoords(), builder.colors());
 
-    return reinterpret_cast<Rml::TextureHandle>(paint);
+  if(indiSize > 0) {
+    memcpy(builder.indices(), batch.indices.data(), indiSize * sizeof(uint16_t));
   }
 
-  return 0;
+  return builder.detach();
 }
 
-Rml::TextureHandle SkiaRenderInterface::GenerateTexture(
-    Rml::Span<const Rml::byte> source, Rml::Vector2i source_dimensions)
+void SkiaRenderInterface::RenderGeometry(
+    Rml::CompiledGeometryHandle handle,
+    Rml::Vector2f translation,
+    Rml::TextureHandle texture)
 {
-  Rml::Vector2i& sd = source_dimensions;
-  RMLUI_ASSERT(source.data() && source.size() == size_t(sd.x * sd.y * 4));
+  auto* textureData = reinterpret_cast<TextureData*>(texture);
 
-  if(sk_sp<SkData> data = SkData::MakeWithCopy(source.data(), source.size())) {
-    // We always make 32bit textures.
-    SkImageInfo info = SkImageInfo::Make(sd.x, sd.y, COLOR_TYPE, ALPHA_TYPE);
+  if(frame_deferred) {
+    auto* geometry = reinterpret_cast<CompiledGeometry*>(handle);
 
-    if(sk_sp<SkImage> img =
-           SkImage::MakeRasterData(info, std::move(data), info.minRowBytes())) {
-      sk_sp<SkShader> shader =
-          img->makeShader(SkSamplingOptions {}, SkMatrix {});
-      auto* paint = new SkPaint {};
-      paint->setShader(shader);
-      return reinterpret_cast<Rml::TextureHandle>(paint);
+    // The cull rectangle includes the scissor region.
+    SkRect bounds = geometry->bounds.makeOffset(translation.x, translation.y);
+    if(!bounds.intersect(cull_rect)) {
+      return;
+    }
+
+    // Also the frames replayed from the cached picture use the texture.
+    if(textureData && !textureData->source.empty()) {
+      UseCachedTexture(*textureData);
     }
+
+    RecordCommand(
+        {handle, translation, texture, scissor_region_enabled,
+         scissor_region_enabled ? rect_scissor : SkRect::MakeEmpty(),
+         geometry->id, textureData ? textureData->id : 0, bounds});
+    return;
   }
 
-  return 0;
+  if(textureData && !textureData->source.empty()) {
+    UseCachedTexture(*textureData);
+  }
+
+  DrawGeometry(
+      *reinterpret_cast<CompiledGeometry*>(handle), translation, texture);
+
+
+  // SkImageInfo skImgInfo = canvas_->imageInfo();
+  // std::vector<unsigned char> frameBuf(skImgInfo.computeMinByteSize());
+  // canvas_->readPixels(
+  //     skImgInfo, frameBuf.data(), skImgInfo.minRowBytes(), 0, 0);
+  // std::string fileOutTest1 = std::to_string(handle) + "__RmlUi_draw.ppm";
+  // writePpmFile(
+  //     frameBuf.data(), skImgInfo.width(), skImgInfo.height(), skImgInfo.bytesPerPixel(),
+  //     fileOutTest1);
 }
 
-void SkiaRenderInterface::ReleaseTexture(Rml::TextureHandle texture_handle)
+void SkiaRenderInterface::DrawGeometry(
+    CompiledGeometry& geometry,
+    Rml::Vector2f translation,
+    Rml::TextureHandle texture)
 {
-  delete reinterpret_cast<SkPaint*>(texture_handle);
+  auto* textureData = reinterpret_cast<TextureData*>(texture);
+  if(textureData && textureData->encoded) {
+    UpdateDecodedSize(*textureData, geometry.texture_draw_size);
+  }
+
+  const SkPaint* skPaint = textureData ? &textureData->paint : nullptr;
+  const SkImage* skImgage = textureData ? textureData->image.get() : nullptr;
+
+  const bool glyphAtlas =
+      glyph_atlas_enabled && textureData && textureData->glyph_atlas;
+
+  for(GeometryBatch& batch : geometry.batches) {
+    ++frame_stats.geometry_draws;
+
+    if(IsCulled(batch, translation)) {
+      ++frame_stats.culled_geometry;
+      continue;
+    }
+
+    ++frame_stats.drawn_geometry;
+    ApplyScissor();
+
+    if(glyphAtlas && DrawAtlas(batch, translation, skImgage)) {
+      continue;
+    }
+
+    if((!skPaint || skImgage) && DrawQuads(batch, translation, skImgage)) {
+      continue;
+    }
+
+    if(geometry_path == GeometryPath::Mesh) {
+      FlushPending();
+      DrawMeshBatch(batch, translation, skPaint, skImgage);
+    } else if(batching_enabled && batch.vertices.size() <= MAX_MERGE_VERTICES) {
+      QueueBatch(batch, translation, texture, skImgage);
+    } else {
+      FlushPending();
+      DrawBatch(batch, translation, skPaint, skImgage);
+    }
+  }
 }
 
-void SkiaRenderInterface::EnableScissorRegion(bool enable)
+void SkiaRenderInterface::UpdateDecodedSize(
+    TextureData& texture, SkISize draw_size)
 {
-  if(enable) {
-    canvas_->clipRect(rect_scissor);
-  } else {
-    canvas_->clipRect(SkRect::MakeEmpty());
+  const SkISize full_size = texture.encoded_size;
+  const SkISize decoded_size = texture.decoded_size;
+
+  // The full size is taken along an axis the geometry gives no size for.
+  const SkISize size = {
+      draw_size.width() > 0
+          ? Rml::Math::Min(draw_size.width(), full_size.width())
+          : full_size.width(),
+      draw_size.height() > 0
+          ? Rml::Math::Min(draw_size.height(), full_size.height())
+          : full_size.height()};
+
+  if(size.width() <= decoded_size.width()
+     && size.height() <= decoded_size.height()) {
+    return;
   }
 
-  scissor_region_enabled = enable;
+  // The first draw decodes the texture, later draws only if they are larger.
+  texture.decoded_size = {
+      Rml::Math::Max(size.width(), decoded_size.width()),
+      Rml::Math::Max(size.height(), decoded_size.height())};
+
+  sk_sp<SkImage> image = SkiaTextureLoader::DecodeScaledImage(
+      texture.encoded, texture.decoded_size, texture_color_type);
+  if(image) {
+    ++texture_stats.scaled_decodes;
+  } else if(!decoded_size.isEmpty()) {
+    // Back from a reduced size to the lazy image of the full size.
+    image = SkiaTextureLoader::MakeLazyImage(texture.encoded);
+  }
+
+  if(!image) {
+    return;
+  }
+
+  // Queued draws and the cached picture hold the previous image.
+  FlushPending();
+  InvalidatePicture();
+
+  // The draw paths map the texture coordinates to the size of the image,
+  // the batches of the previous size are converted again.
+  texture.paint.setShader(image->makeShader(SkSamplingOptions {}, SkMatrix {}));
+  texture.image = std::move(image);
+  UpdateTextureBytes(texture);
 }
 
-void SkiaRenderInterface::SetScissorRegion(Rml::Rectanglei region)
+void SkiaRenderInterface::AddCachedTexture(
+    TextureData& texture, const Rml::String& source)
 {
-  rect_scissor = SkRect::Make(
-      {region.Left(), region.Top(), region.Right(), region.Bottom()});
+  texture.source = source;
+  texture.drawn_frame = frame_number;
+  LinkTexture(texture);
+}
 
-  if(scissor_region_enabled) {
-    canvas_->clipRect(rect_scissor);
+void SkiaRenderInterface::UseCachedTexture(TextureData& texture)
+{
+  texture.drawn_frame = frame_number;
+
+  if(texture.evicted) {
+    ++texture_stats.cache_misses;
+    ReloadTexture(texture);
+    LinkTexture(texture);
+    return;
+  }
+
+  ++texture_stats.cache_hits;
+  if(lru_head != &texture) {
+    UnlinkTexture(texture);
+    LinkTexture(texture);
+  }
+}
+
+void SkiaRenderInterface::ReloadTexture(TextureData& texture)
+{
+  sk_sp<SkData> encoded;
+  sk_sp<SkImage> image = LoadTextureImage(texture.source, encoded);
+  if(!image) {
+    // The texture draws nothing if its file is gone.
+    image = GetPlaceholderImage();
+  }
+
+  // Encoded images are decoded at the size they are drawn at again.
+  texture.encoded = std::move(encoded);
+  texture.decoded_size = {0, 0};
+  texture.paint.setShader(image->makeShader(SkSamplingOptions {}, SkMatrix {}));
+  texture.image = std::move(image);
+  texture.evicted = false;
+  UpdateTextureBytes(texture);
+}
+
+void SkiaRenderInterface::EvictTextures()
+{
+  TextureData* texture = lru_tail;
+
+  while(texture && texture_stats.resident_bytes > texture_budget) {
+    TextureData* previous = texture->lru_prev;
+
+    // The draws of the current frame may still be replayed.
+    if(texture->drawn_frame != frame_number) {
+      UnlinkTexture(*texture);
+
+      texture->image.reset();
+      texture->paint.setShader(nullptr);
+      texture->encoded.reset();
+      texture->evicted = true;
+      UpdateTextureBytes(*texture);
+
+      ++texture_stats.evictions;
+    }
+
+    texture = previous;
+  }
+}
+
+void SkiaRenderInterface::LinkTexture(TextureData& texture)
+{
+  texture.lru_prev = nullptr;
+  texture.lru_next = lru_head;
+  if(lru_head) {
+    lru_head->lru_prev = &texture;
+  } else {
+    lru_tail = &texture;
+  }
+  lru_head = &texture;
+}
+
+void SkiaRenderInterface::UnlinkTexture(TextureData& texture)
+{
+  if(texture.lru_prev) {
+    texture.lru_prev->lru_next = texture.lru_next;
+  } else if(lru_head == &texture) {
+    lru_head = texture.lru_next;
+  } else {
+    // Not in the list.
+    return;
+  }
+
+  if(texture.lru_next) {
+    texture.lru_next->lru_prev = texture.lru_prev;
+  } else {
+    lru_tail = texture.lru_prev;
+  }
+
+  texture.lru_prev = nullptr;
+  texture.lru_next = nullptr;
+}
+
+void SkiaRenderInterface::UpdateTextureBytes(TextureData& texture)
+{
+  // The shared placeholder is not counted.
+  const size_t bytes = texture.image && texture.image != placeholder_image
+      ? texture.image->imageInfo().computeMinByteSize()
+      : 0;
+
+  texture_stats.resident_bytes -= texture.bytes;
+  texture_stats.resident_bytes += bytes;
+  texture.bytes = bytes;
+}
+
+static uint64_t HashValue(uint64_t hash, uint64_t value)
+{
+  return (hash ^ value) * FNV_PRIME;
+}
+
+static uint64_t HashFloat(uint64_t hash, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return HashValue(hash, bits);
+}
+
+bool SkiaRenderInterface::FrameCommand::operator==(
+    const FrameCommand& other) const
+{
+  return geometry_id == other.geometry_id && translation == other.translation
+      && texture_id == other.texture_id
+      && scissor_enabled == other.scissor_enabled && scissor == other.scissor;
+}
+
+uint64_t SkiaRenderInterface::FrameCommand::Hash(uint64_t hash) const
+{
+  hash = HashValue(hash, geometry_id);
+  hash = HashFloat(hash, translation.x);
+  hash = HashFloat(hash, translation.y);
+  hash = HashValue(hash, texture_id);
+  hash = HashValue(hash, scissor_enabled);
+  hash = HashFloat(hash, scissor.fLeft);
+  hash = HashFloat(hash, scissor.fTop);
+  hash = HashFloat(hash, scissor.fRight);
+  return HashFloat(hash, scissor.fBottom);
+}
+
+void SkiaRenderInterface::RecordCommand(const FrameCommand& command)
+{
+  command_hash = command.Hash(command_hash);
+
+  if(command_count == command_capacity) {
+    const int capacity = Rml::Math::Max(256, command_capacity * 2);
+    auto* list = frame_arena.Allocate<FrameCommand>(capacity);
+
+    if(!list) {
+      // The frame can not be compared any more, it is drawn as is.
+      PlayCommands();
+      PlayCommands(&command, 1);
+      commands_complete = false;
+      command_count = 0;
+      played_commands = 0;
+      return;
+    }
+
+    if(command_count > 0) {
+      memcpy(list, commands, command_count * sizeof(FrameCommand));
+    }
+    commands = list;
+    command_capacity = capacity;
+  }
+
+  commands[command_count++] = command;
+}
+
+void SkiaRenderInterface::BeginRecording()
+{
+  if(picture_recording) {
+    return;
+  }
+
+  const SkISize size = canvas_->getBaseLayerSize();
+  SkRTreeFactory rTreeFactory;
+
+  // The bounding box hierarchy lets a clipped playback skip the draws outside
+  // the clip.
+  draw_canvas = picture_recorder.beginRecording(
+      SkRect::MakeWH(size.width(), size.height()), &rTreeFactory);
+  picture_recording = true;
+}
+
+void SkiaRenderInterface::PlayCommand(const FrameCommand& command)
+{
+  BeginRecording();
+  SetScissorState(command.scissor_enabled, command.scissor);
+  DrawGeometry(
+      *reinterpret_cast<CompiledGeometry*>(command.geometry),
+      command.translation, command.texture);
+}
+
+// Plays the commands not yet played into the picture recorder.
+void SkiaRenderInterface::PlayCommands()
+{
+  PlayCommands(commands + played_commands, command_count - played_commands);
+  played_commands = command_count;
+}
+
+void SkiaRenderInterface::PlayCommands(const FrameCommand* list, int count)
+{
+  if(count == 0) {
+    return;
+  }
+
+  // The commands bring their own scissor state, the one set by RmlUi is
+  // restored afterwards.
+  const bool scissorEnabled = scissor_region_enabled;
+  const SkRect scissorRect = rect_scissor;
+
+  for(int i = 0; i < count; ++i) {
+    PlayCommand(list[i]);
+  }
+
+  FlushPending();
+  SetScissorState(scissorEnabled, scissorRect);
+}
+
+void SkiaRenderInterface::PresentDeferredFrame()
+{
+  const SkISize size = canvas_->getBaseLayerSize();
+
+  const bool unchanged = commands_complete && previous_frame_valid
+      && previous_size == size && command_hash == previous_hash
+      && previous_commands.size() == static_cast<size_t>(command_count)
+      && std::equal(commands, commands + command_count, previous_commands.begin());
+
+  if(damage_tracking_enabled) {
+    ComputeDamage(unchanged);
+  }
+
+  // With damage tracking, an unchanged frame draws nothing.
+  const bool redraw = !damage_tracking_enabled || !damage_region.isEmpty();
+  sk_sp<SkPicture> picture;
+
+  if(unchanged && cached_picture) {
+    ++picture_cache_stats.hits;
+    picture = cached_picture;
+
+    // A geometry or texture released during the frame started a recording
+    // the cached picture replaces.
+    if(picture_recording) {
+      picture_recorder.finishRecordingAsPicture();
+      picture_recording = false;
+      draw_canvas = canvas_;
+      ResetScissor();
+    }
+  } else if(picture_cache_enabled || redraw || picture_recording) {
+    if(picture_cache_enabled) {
+      ++picture_cache_stats.misses;
+    }
+
+    BeginRecording();
+    PlayCommands();
+    ResetScissor();
+
+    picture = picture_recorder.finishRecordingAsPicture();
+    picture_recording = false;
+    draw_canvas = canvas_;
+
+    // The picture of a frame which lost commands is not described by the
+    // previous commands, and is never replayed.
+    if(picture_cache_enabled) {
+      cached_picture = commands_complete ? picture : nullptr;
+    }
+  }
+
+  if(redraw && picture
+     && !DrawPictureTiled(picture.get(), damage_tracking_enabled)) {
+    SkAutoCanvasRestore acr(canvas_, true);
+    if(damage_tracking_enabled) {
+      canvas_->clipRegion(damage_region);
+    }
+    canvas_->clear(BACKGROUND_COLOR);
+    canvas_->drawPicture(picture);
+  }
+
+  previous_frame_valid = commands_complete;
+  if(previous_frame_valid) {
+    previous_commands.assign(commands, commands + command_count);
+    previous_hash = command_hash;
+    previous_size = size;
+  }
+}
+
+// Diffs the commands with the previous frame. A pixel does not change if the
+// same commands cover it in the same order, so the bounds of the commands
+// that are new, gone or drawn out of order are damaged.
+void SkiaRenderInterface::ComputeDamage(bool unchanged)
+{
+  damage_region.setEmpty();
+
+  if(unchanged) {
+    return;
+  }
+
+  const SkISize size = canvas_->getBaseLayerSize();
+  const int previousCount = static_cast<int>(previous_commands.size());
+
+  // Previous commands by identity, with equal commands chained in order.
+  struct Slot
+  {
+    int key;
+    int head;
+  };
+
+  int tableSize = 16;
+  while(tableSize < previousCount * 2) {
+    tableSize *= 2;
+  }
+
+  auto* table = frame_arena.Allocate<Slot>(tableSize);
+  auto* next = frame_arena.Allocate<int>(previousCount + 1);
+  auto* matched = frame_arena.Allocate<bool>(previousCount + 1);
+
+  if(!previous_frame_valid || !commands_complete || previous_size != size
+     || !table || !next || !matched) {
+    damage_region.setRect(SkIRect::MakeSize(size));
+    return;
+  }
+
+  auto findSlot = [&](const FrameCommand& command) -> Slot& {
+    int i = static_cast<int>(command.Hash(FNV_OFFSET_BASIS)) & (tableSize - 1);
+    while(table[i].key >= 0 && !(previous_commands[table[i].key] == command)) {
+      i = (i + 1) & (tableSize - 1);
+    }
+    return table[i];
+  };
+
+  for(int i = 0; i < tableSize; ++i) {
+    table[i] = {-1, -1};
+  }
+
+  for(int i = previousCount - 1; i >= 0; --i) {
+    Slot& slot = findSlot(previous_commands[i]);
+    slot.key = i;
+    next[i] = slot.head;
+    slot.head = i;
+    matched[i] = false;
+  }
+
+  auto addDamage = [&](const SkRect& bounds) {
+    damage_region.op(bounds.roundOut(), SkRegion::kUnion_Op);
+  };
+
+  int lastMatched = -1;
+
+  for(int j = 0; j < command_count; ++j) {
+    Slot& slot = findSlot(commands[j]);
+
+    if(slot.head >= 0) {
+      const int i = slot.head;
+      slot.head = next[i];
+      matched[i] = true;
+
+      if(i > lastMatched) {
+        lastMatched = i;
+        continue;
+      }
+    }
+
+    addDamage(commands[j].bounds);
+  }
+
+  for(int i = 0; i < previousCount; ++i) {
+    if(!matched[i]) {
+      addDamage(previous_commands[i].bounds);
+    }
+  }
+
+  // Many small regions are redrawn as one, each costs a picture playback
+  // clip.
+  if(damage_region.computeRegionComplexity() > MAX_DAMAGE_RECTS) {
+    damage_region.setRect(damage_region.getBounds());
+  }
+}
+
+// Each tile is drawn by its own canvas over the tile's part of the canvas
+// pixels, the tiles do not share any drawing state. The pixels are written
+// behind the back of the surface, so image snapshots of it must not be kept
+// across frames.
+bool SkiaRenderInterface::DrawPictureTiled(
+    const SkPicture* picture, bool clip_to_damage)
+{
+  if(!raster_threads) {
+    return false;
+  }
+
+  // The tiles are written to the pixels of the surface past its canvas, so
+  // the surface copies them first if a snapshot shares them. The pixels may
+  // move, they are peeked after that. Outside of the damage the tiles keep
+  // the pixels, otherwise they clear all of them.
+  if(SkSurface* surface = canvas_->getSurface()) {
+    surface->notifyContentWillChange(
+        clip_to_damage ? SkSurface::kRetain_ContentChangeMode
+                       : SkSurface::kDiscard_ContentChangeMode);
+  }
+
+  SkPixmap pixmap;
+  if(!canvas_->peekPixels(&pixmap)) {
+    return false;
+  }
+
+  const int columns = (pixmap.width() + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+  const int rows = (pixmap.height() + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+
+  raster_threads->ParallelFor(columns * rows, [&](int tile) {
+    const SkIRect tileRect = SkIRect::MakeXYWH(
+        tile % columns * RASTER_TILE_SIZE, tile / columns * RASTER_TILE_SIZE,
+        RASTER_TILE_SIZE, RASTER_TILE_SIZE);
+
+    SkPixmap tilePixmap;
+    if(!pixmap.extractSubset(&tilePixmap, tileRect)) {
+      return;
+    }
+
+    if(clip_to_damage && !damage_region.intersects(tileRect)) {
+      return;
+    }
+
+    std::unique_ptr<SkCanvas> tileCanvas = SkCanvas::MakeRasterDirect(
+        tilePixmap.info(), tilePixmap.writable_addr(), tilePixmap.rowBytes());
+    if(!tileCanvas) {
+      return;
+    }
+
+    // Clips are in device space, the damage is moved to the tile origin.
+    if(clip_to_damage) {
+      SkRegion tileDamage;
+      damage_region.translate(-tileRect.fLeft, -tileRect.fTop, &tileDamage);
+      tileCanvas->clipRegion(tileDamage);
+    }
+
+    tileCanvas->translate(-tileRect.fLeft, -tileRect.fTop);
+    tileCanvas->clear(BACKGROUND_COLOR);
+    tileCanvas->drawPicture(picture);
+  });
+
+  return true;
+}
+
+void SkiaRenderInterface::InvalidatePicture()
+{
+  if(cached_picture) {
+    ++picture_cache_stats.invalidations;
+    cached_picture.reset();
+  }
+}
+
+// The cached picture is recorded from the previous commands.
+void SkiaRenderInterface::InvalidatePictureUsing(uint32_t resource_id)
+{
+  if(!cached_picture) {
+    return;
+  }
+
+  for(const FrameCommand& command : previous_commands) {
+    if(command.geometry_id == resource_id || command.texture_id == resource_id) {
+      InvalidatePicture();
+      return;
+    }
+  }
+}
+
+void SkiaRenderInterface::DrawBatch(
+    GeometryBatch& batch,
+    Rml::Vector2f translation,
+    const SkPaint* paint,
+    const SkImage* image)
+{
+  const SkVertices* skVertices = nullptr;
+
+  if(!image) {
+    // Built once, by the first untextured draw of the batch.
+    if(!batch.sk_vertices) {
+      batch.sk_vertices = MakeVertices(batch, nullptr);
+      ++frame_stats.vertex_builds;
+    }
+    skVertices = batch.sk_vertices.get();
+  } else {
+    // Texture coordinates depend on the texture size only, so they are
+    // rebuilt only when the batch is drawn with a texture of another size.
+    if(!batch.sk_textured_vertices
+       || batch.texture_size != image->dimensions()) {
+      batch.sk_textured_vertices = MakeVertices(batch, image);
+      batch.texture_size = image->dimensions();
+      ++frame_stats.vertex_builds;
+    }
+    skVertices = batch.sk_textured_vertices.get();
+  }
+
+  if(!skVertices) {
+    return;
+  }
+
+  SkAutoCanvasRestore acr(draw_canvas, true);
+  draw_canvas->translate(translation.x, translation.y);
+
+  if(!image && OmitsColors(batch, image)) {
+    // Vertices without colours take the paint colour, the blend mode is
+    // ignored.
+    ++frame_stats.canvas_draws;
+    draw_canvas->drawVertices(
+        skVertices, SkBlendMode::kDst, GetColorPaint(batch.color));
+    return;
+  }
+
+  DrawVertices(skVertices, paint);
+}
+
+void SkiaRenderInterface::MakeAtlasSprites(
+    GeometryBatch& batch, const SkImage* image)
+{
+  const Rml::Vector2f texScale = GetTexScale(image);
+  const size_t quadCount = batch.quads.size();
+
+  batch.atlas_xforms.resize(quadCount);
+  batch.atlas_rects.resize(quadCount);
+  batch.atlas_colors.clear();
+
+  for(size_t i = 0; i < quadCount; ++i) {
+    const GeometryQuad& quad = batch.quads[i];
+    const SkRect src = SkRect::MakeLTRB(
+        quad.tex_rect.fLeft * texScale.x, quad.tex_rect.fTop * texScale.y,
+        quad.tex_rect.fRight * texScale.x, quad.tex_rect.fBottom * texScale.y);
+
+    // A sprite is scaled uniformly, glyphs are drawn at 1:1 scale.
+    const float scaleX = src.width() > 0 ? quad.rect.width() / src.width() : 0;
+    const float scaleY =
+        src.height() > 0 ? quad.rect.height() / src.height() : 0;
+
+    if(scaleX <= 0
+       || Rml::Math::AbsoluteValue(scaleX - scaleY)
+           > MAX_ATLAS_SCALE_ERROR * scaleX) {
+      batch.atlas_xforms.clear();
+      batch.atlas_rects.clear();
+      return;
+    }
+
+    batch.atlas_xforms[i] =
+        SkRSXform::Make(scaleX, 0, quad.rect.fLeft, quad.rect.fTop);
+    batch.atlas_rects[i] = src;
+  }
+
+  // Opaque white glyphs take the atlas as is.
+  if(!batch.uniform_color || batch.color != SK_ColorWHITE) {
+    batch.atlas_colors.reserve(quadCount);
+    for(const GeometryQuad& quad : batch.quads) {
+      batch.atlas_colors.push_back(quad.color);
+    }
+  }
+}
+
+bool SkiaRenderInterface::DrawAtlas(
+    GeometryBatch& batch, Rml::Vector2f translation, const SkImage* image)
+{
+  if(batch.quads.empty() || !image) {
+    return false;
+  }
+
+  // The sprites depend on the atlas size only, like the textured vertices.
+  if(batch.atlas_texture_size != image->dimensions()) {
+    MakeAtlasSprites(batch, image);
+    batch.atlas_texture_size = image->dimensions();
+  }
+
+  if(batch.atlas_xforms.empty()) {
+    return false;
+  }
+
+  FlushPending();
+
+  SkAutoCanvasRestore acr(draw_canvas, true);
+  draw_canvas->translate(translation.x, translation.y);
+  ++frame_stats.canvas_draws;
+
+  // The glyph colours modulate the atlas as the vertex colours do on the
+  // vertices path.
+  draw_canvas->drawAtlas(
+      image, batch.atlas_xforms.data(), batch.atlas_rects.data(),
+      batch.atlas_colors.empty() ? nullptr : batch.atlas_colors.data(),
+      static_cast<int>(batch.atlas_xforms.size()), SkBlendMode::kModulate,
+      SkSamplingOptions {}, &batch.bounds, &GetDrawPaint(nullptr));
+  return true;
+}
+
+bool SkiaRenderInterface::DrawQuads(
+    const GeometryBatch& batch,
+    Rml::Vector2f translation,
+    const SkImage* image)
+{
+  // Textured quads are drawn as image rectangles only if their colour does
+  // not change the texture.
+  if(batch.quads.empty() || (image && !OmitsColors(batch, image))) {
+    return false;
+  }
+
+  FlushPending();
+
+  SkAutoCanvasRestore acr(draw_canvas, true);
+  draw_canvas->translate(translation.x, translation.y);
+  frame_stats.canvas_draws += static_cast<int>(batch.quads.size());
+
+  if(image) {
+    const Rml::Vector2f texScale = GetTexScale(image);
+
+    for(const GeometryQuad& quad : batch.quads) {
+      const SkRect src = SkRect::MakeLTRB(
+          quad.tex_rect.fLeft * texScale.x, quad.tex_rect.fTop * texScale.y,
+          quad.tex_rect.fRight * texScale.x, quad.tex_rect.fBottom * texScale.y);
+      draw_canvas->drawImageRect(
+          image, src, quad.rect, SkSamplingOptions {},
+          &GetDrawPaint(nullptr), SkCanvas::kFast_SrcRectConstraint);
+    }
+  } else {
+    for(const GeometryQuad& quad : batch.quads) {
+      draw_canvas->drawRect(quad.rect, GetColorPaint(quad.color));
+    }
+  }
+
+  return true;
+}
+
+void SkiaRenderInterface::DrawVertices(
+    const SkVertices* vertices, const SkPaint* paint)
+{
+  ++frame_stats.canvas_draws;
+
+  // src + dst == (srcRGB * 1) + (dstRGB * (1 - srcA))
+  // src + dst == (srcA * 1) + (dstA * (1 - srcA))
+  // kModulate
+  // kSrc, kSrcIn
+  // kDstIn, kDstOut, kDstATop, kXor, kDifference, kExclusion
+
+  if(paint) {
+    draw_canvas->drawVertices(
+        vertices, SkBlendMode::kModulate, GetDrawPaint(paint));
+  } else {
+    draw_canvas->drawVertices(
+        vertices, SkBlendMode::kDst, GetDrawPaint(nullptr));
+  }
+}
+
+bool SkiaRenderInterface::MakeMeshBuffers(GeometryBatch& batch)
+{
+  // Buffers for the CPU backend, no GPU context.
+  batch.mesh_vertex_buffer = SkMesh::MakeVertexBuffer(
+      nullptr, batch.vertices.data(),
+      batch.vertices.size() * sizeof(Rml::Vertex));
+  batch.mesh_index_buffer = SkMesh::MakeIndexBuffer(
+      nullptr, batch.indices.data(), batch.indices.size() * sizeof(uint16_t));
+
+  return batch.mesh_vertex_buffer && batch.mesh_index_buffer;
+}
+
+SkMesh SkiaRenderInterface::MakeMesh(
+    const GeometryBatch& batch, const SkImage* image) const
+{
+  const Rml::Vector2f texScale = GetTexScale(image);
+  RMLUI_ASSERT(mesh_specification->uniformSize() == sizeof(texScale));
+
+  SkMesh::Result result = SkMesh::MakeIndexed(
+      mesh_specification, SkMesh::Mode::kTriangles, batch.mesh_vertex_buffer,
+      batch.vertices.size(), 0, batch.mesh_index_buffer, batch.indices.size(),
+      0, SkData::MakeWithCopy(&texScale, sizeof(texScale)), batch.bounds);
+
+  if(!result.mesh.isValid()) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR, "Skia can not create the mesh: %s",
+        result.error.c_str());
+  }
+
+  return result.mesh;
+}
+
+void SkiaRenderInterface::DrawMeshBatch(
+    GeometryBatch& batch,
+    Rml::Vector2f translation,
+    const SkPaint* paint,
+    const SkImage* image)
+{
+  if(batch.indices.empty()) {
+    return;
+  }
+
+  if(!batch.mesh_vertex_buffer && !MakeMeshBuffers(batch)) {
+    return;
+  }
+
+  SkMesh* mesh = &batch.mesh;
+
+  if(image) {
+    if(!batch.textured_mesh.isValid()
+       || batch.mesh_texture_size != image->dimensions()) {
+      batch.textured_mesh = MakeMesh(batch, image);
+      batch.mesh_texture_size = image->dimensions();
+    }
+    mesh = &batch.textured_mesh;
+  } else if(!batch.mesh.isValid()) {
+    batch.mesh = MakeMesh(batch, nullptr);
+  }
+
+  if(!mesh->isValid()) {
+    return;
+  }
+
+  ++frame_stats.canvas_draws;
+
+  SkAutoCanvasRestore acr(draw_canvas, true);
+  draw_canvas->translate(translation.x, translation.y);
+
+  // The mesh colour is the destination and the paint is the source of the
+  // blender, as with drawVertices().
+  if(paint) {
+    draw_canvas->drawMesh(
+        *mesh, SkBlender::Mode(SkBlendMode::kModulate), GetDrawPaint(paint));
+  } else {
+    draw_canvas->drawMesh(
+        *mesh, SkBlender::Mode(SkBlendMode::kDst), GetDrawPaint(nullptr));
+  }
+}
+
+void SkiaRenderInterface::QueueBatch(
+    GeometryBatch& batch,
+    Rml::Vector2f translation,
+    Rml::TextureHandle texture,
+    const SkImage* image)
+{
+  // The blend mode follows from the texture, and scissor changes flush the
+  // pending draws, so only the texture and the index range are checked here.
+  if(pending_draws > 0
+     && (texture != pending_texture
+         || pending_vertices + batch.vertices.size() > MAX_BATCH_VERTICES)) {
+    FlushPending();
+  }
+
+  if(pending_draws == pending_capacity) {
+    const int capacity = Rml::Math::Max(64, pending_capacity * 2);
+    auto* queue = frame_arena.Allocate<QueuedDraw>(capacity);
+
+    if(!queue) {
+      FlushPending();
+      DrawBatch(batch, translation, GetTexturePaint(texture), image);
+      return;
+    }
+
+    if(pending_draws > 0) {
+      memcpy(queue, pending, pending_draws * sizeof(QueuedDraw));
+    }
+
+    pending = queue;
+    pending_capacity = capacity;
+  }
+
+  if(pending_draws == 0) {
+    pending_texture = texture;
+    pending_image = image;
+  }
+
+  pending[pending_draws++] = {&batch, translation};
+  pending_vertices += batch.vertices.size();
+  pending_indices += batch.indices.size();
+}
+
+void SkiaRenderInterface::FlushPending()
+{
+  if(pending_draws == 0) {
+    return;
+  }
+
+  const SkPaint* skPaint = GetTexturePaint(pending_texture);
+
+  if(pending_draws == 1) {
+    DrawBatch(
+        *pending[0].batch, pending[0].translation, skPaint, pending_image);
+  } else {
+    // Unchanged merges are drawn from the vertices of an earlier frame, so a
+    // steady-state frame converts no vertices.
+    const SkISize textureSize =
+        pending_image ? pending_image->dimensions() : SkISize {0, 0};
+    uint64_t hash = HashValue(FNV_OFFSET_BASIS, textureSize.width());
+    hash = HashValue(hash, textureSize.height());
+    for(int i = 0; i < pending_draws; ++i) {
+      hash = HashValue(hash, pending[i].batch->id);
+      hash = HashFloat(hash, pending[i].translation.x);
+      hash = HashFloat(hash, pending[i].translation.y);
+    }
+
+    MergedVertices& merged = merged_vertices[hash];
+    bool unchanged = merged.vertices && merged.texture_size == textureSize
+        && merged.draws.size() == static_cast<size_t>(pending_draws);
+    for(int i = 0; unchanged && i < pending_draws; ++i) {
+      unchanged = merged.draws[i].batch_id == pending[i].batch->id
+          && merged.draws[i].translation == pending[i].translation;
+    }
+
+    if(!unchanged) {
+      merged.draws.resize(pending_draws);
+      for(int i = 0; i < pending_draws; ++i) {
+        merged.draws[i] = {pending[i].batch->id, pending[i].translation};
+      }
+      merged.texture_size = textureSize;
+      merged.vertices = MakeMergedVertices();
+      ++frame_stats.vertex_builds;
+    }
+
+    merged.drawn_frame = frame_number;
+    merged_frame = frame_number;
+    if(merged.vertices) {
+      DrawVertices(merged.vertices.get(), skPaint);
+    }
+  }
+
+  pending_draws = 0;
+  pending_vertices = 0;
+  pending_indices = 0;
+  pending_texture = 0;
+  pending_image = nullptr;
+}
+
+sk_sp<SkVertices> SkiaRenderInterface::MakeMergedVertices() const
+{
+  uint32_t flags = SkVertices::kHasColors_BuilderFlag;
+  if(pending_image) {
+    flags |= SkVertices::kHasTexCoords_BuilderFlag;
+  }
+
+  // The merged vertices are written straight into the builder, no
+  // intermediate buffers are needed.
+  SkVertices::Builder builder(
+      SkVertices::kTriangles_VertexMode, static_cast<int>(pending_vertices),
+      static_cast<int>(pending_indices), flags);
+  if(!builder.isValid()) {
+    return nullptr;
+  }
+
+  SkPoint* skPos = builder.positions();
+  SkPoint* skTex = builder.texCoords();
+  SkColor* skColor = builder.colors();
+  uint16_t* skIndices = builder.indices();
+  const Rml::Vector2f texScale = GetTexScale(pending_image);
+  int base = 0;
+
+  for(int i = 0; i < pending_draws; ++i) {
+    const GeometryBatch& batch = *pending[i].batch;
+    const int count = static_cast<int>(batch.vertices.size());
+
+    SkiaKernels::ConvertVertices(
+        batch.vertices.data(), count, pending[i].translation, texScale,
+        skPos + base, skTex ? skTex + base : nullptr, skColor + base);
+
+    for(uint16_t index : batch.indices) {
+      *skIndices++ = static_cast<uint16_t>(base + index);
+    }
+
+    base += count;
+  }
+
+  return builder.detach();
+}
+
+// Frames replayed from the cached picture draw no merged vertices and keep
+// them all.
+void SkiaRenderInterface::EvictMergedVertices()
+{
+  if(merged_frame != frame_number) {
+    return;
+  }
+
+  for(auto it = merged_vertices.begin(); it != merged_vertices.end();) {
+    if(it->second.drawn_frame != frame_number) {
+      it = merged_vertices.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void SkiaRenderInterface::ReleaseGeometry(Rml::CompiledGeometryHandle geometry)
+{
+  // A single pending draw refers to its compiled batch.
+  FlushPending();
+
+  // The commands of the frame may refer to the geometry.
+  if(frame_deferred) {
+    PlayCommands();
+  }
+
+  auto* compiledGeometry = reinterpret_cast<CompiledGeometry*>(geometry);
+  InvalidatePictureUsing(compiledGeometry->id);
+
+  delete compiledGeometry;
+}
+
+SkiaRenderInterface::TextureData* SkiaRenderInterface::CreateTextureData(
+    sk_sp<SkImage> image)
+{
+  auto* textureData = new TextureData {};
+  textureData->id = next_resource_id++;
+  textureData->paint.setShader(
+      image->makeShader(SkSamplingOptions {}, SkMatrix {}));
+  textureData->image = std::move(image);
+  UpdateTextureBytes(*textureData);
+  return textureData;
+}
+
+sk_sp<SkImage> SkiaRenderInterface::GetPlaceholderImage()
+{
+  if(!placeholder_image) {
+    SkBitmap placeholder;
+    placeholder.allocPixels(
+        SkImageInfo::Make(1, 1, texture_color_type, ALPHA_TYPE));
+    placeholder.eraseColor(SK_ColorTRANSPARENT);
+    placeholder.setImmutable();
+    placeholder_image = placeholder.asImage();
+  }
+  return placeholder_image;
+}
+
+sk_sp<SkImage> SkiaRenderInterface::DecodeTgaTexture(
+    const SkData& file_data) const
+{
+  SkBitmap skBitmap;
+  bool opaque = false;
+  if(!SkiaTextureLoader::DecodeTga(
+         file_data.data(), file_data.size(), texture_color_type, skBitmap,
+         opaque)) {
+    return nullptr;
+  }
+
+  // Opaque textures are stored in the colour type of low bit depth canvases,
+  // converted once here.
+  if(opaque && opaque_texture_color_type != texture_color_type) {
+    SkBitmap opaqueBitmap;
+    if(opaqueBitmap.tryAllocPixels(
+           skBitmap.info()
+               .makeColorType(opaque_texture_color_type)
+               .makeAlphaType(SkAlphaType::kOpaque_SkAlphaType))
+       && skBitmap.pixmap().readPixels(opaqueBitmap.pixmap())) {
+      skBitmap = opaqueBitmap;
+    }
+  }
+
+  skBitmap.setImmutable();
+  return skBitmap.asImage();
+}
+
+Rml::TextureHandle SkiaRenderInterface::LoadTexture(
+    Rml::Vector2i& texture_dimensions, const Rml::String& source)
+{
+  if(texture_loader) {
+    return LoadTextureAsync(texture_dimensions, source);
+  }
+
+  sk_sp<SkData> encoded;
+  sk_sp<SkImage> img = LoadTextureImage(source, encoded);
+  if(!img) {
+    return 0;
+  }
+
+  texture_dimensions.x = img->width();
+  texture_dimensions.y = img->height();
+
+  TextureData* textureData = CreateTextureData(img);
+  if(encoded) {
+    textureData->encoded = std::move(encoded);
+    textureData->encoded_size = img->dimensions();
+    ++texture_stats.encoded_textures;
+  }
+
+  AddCachedTexture(*textureData, source);
+  return reinterpret_cast<Rml::TextureHandle>(textureData);
+}
+
+sk_sp<SkImage> SkiaRenderInterface::LoadTextureImage(
+    const Rml::String& source, sk_sp<SkData>& encoded) const
+{
+  sk_sp<SkData> file_data = SkiaTextureLoader::LoadFile(source);
+  if(!file_data) {
+    return nullptr;
+  }
+
+  // Images in the formats of the Skia codecs are decoded on their first draw.
+  if(sk_sp<SkImage> img = SkiaTextureLoader::MakeLazyImage(file_data)) {
+    encoded = std::move(file_data);
+    return img;
+  }
+
+  // Decoded straight from the file data, which is released after that.
+  return DecodeTgaTexture(*file_data);
+}
+
+Rml::TextureHandle SkiaRenderInterface::LoadTextureAsync(
+    Rml::Vector2i& texture_dimensions, const Rml::String& source)
+{
+  auto it = loaded_texture_sizes.find(source);
+  texture_dimensions = it != loaded_texture_sizes.end()
+      ? it->second
+      : Rml::Vector2i(0, 0);
+
+  TextureData* textureData = CreateTextureData(GetPlaceholderImage());
+  loading_textures[textureData->id] = textureData;
+
+  const uint32_t textureId = textureData->id;
+  const auto texture = reinterpret_cast<Rml::TextureHandle>(textureData);
+  texture_loader->Push([this, textureId, texture, source]() {
+    LoadTextureTask(textureId, texture, source);
+  });
+
+  return texture;
+}
+
+void SkiaRenderInterface::LoadTextureTask(
+    uint32_t texture_id, Rml::TextureHandle texture, const Rml::String& source)
+{
+  // Decoded in full here, so no draw decodes on the render thread.
+  sk_sp<SkImage> image;
+  if(sk_sp<SkData> file_data = SkiaTextureLoader::LoadFile(source)) {
+    if(sk_sp<SkImage> lazy = SkiaTextureLoader::MakeLazyImage(file_data)) {
+      image = lazy->makeRasterImage();
+    } else {
+      image = DecodeTgaTexture(*file_data);
+    }
+  }
+
+  TextureLoadedCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(loaded_mutex);
+    loaded_textures.push_back({texture_id, source, std::move(image)});
+    callback = texture_loaded_callback;
+  }
+
+  if(callback) {
+    callback(texture);
+  }
+}
+
+void SkiaRenderInterface::SwapLoadedTextures()
+{
+  Rml::Vector<LoadedTexture> loaded;
+  {
+    std::lock_guard<std::mutex> lock(loaded_mutex);
+    if(loaded_textures.empty()) {
+      return;
+    }
+    loaded.swap(loaded_textures);
+  }
+
+  for(LoadedTexture& texture : loaded) {
+    // Textures released while loading are not found.
+    auto it = loading_textures.find(texture.texture_id);
+    if(it == loading_textures.end()) {
+      continue;
+    }
+
+    TextureData* textureData = it->second;
+    loading_textures.erase(it);
+
+    // The placeholder stays if the texture failed to load.
+    if(!texture.image) {
+      continue;
+    }
+
+    loaded_texture_sizes[texture.source] = {
+        texture.image->width(), texture.image->height()};
+
+    // A new id, the cached frames show the placeholder.
+    textureData->id = next_resource_id++;
+    textureData->paint.setShader(
+        texture.image->makeShader(SkSamplingOptions {}, SkMatrix {}));
+    textureData->image = std::move(texture.image);
+    UpdateTextureBytes(*textureData);
+    AddCachedTexture(*textureData, texture.source);
+
+    ++texture_stats.async_loads;
+    InvalidatePicture();
+  }
+}
+
+Rml::TextureHandle SkiaRenderInterface::GenerateTexture(
+    Rml::Span<const Rml::byte> source, Rml::Vector2i source_dimensions)
+{
+  Rml::Vector2i& sd = source_dimensions;
+  RMLUI_ASSERT(source.data() && source.size() == size_t(sd.x * sd.y * 4));
+
+  // RmlUi generates RGBA pixels, converted to the texture colour type while
+  // they are copied.
+  SkImageInfo info =
+      SkImageInfo::Make(sd.x, sd.y, texture_color_type, ALPHA_TYPE);
+  SkPixmap sourcePixmap(
+      info.makeColorType(SkColorType::kRGBA_8888_SkColorType),
+      source.data(),
+      info.minRowBytes());
+
+  // Pixels in memory of the texture memory are taken as they are, a BGRA
+  // texture swaps their red and blue in place.
+  sk_sp<SkData> data =
+      texture_memory ? texture_memory->TakeTexture(source) : nullptr;
+  if(data) {
+    if(texture_color_type == SkColorType::kBGRA_8888_SkColorType) {
+      SkSwizzle_RB(
+          static_cast<uint32_t*>(data->writable_data()),
+          static_cast<const uint32_t*>(data->data()),
+          sd.x * sd.y);
+    }
+    ++texture_stats.adopted_textures;
+  } else if(texture_color_type == SkColorType::kRGBA_8888_SkColorType) {
+    data = SkData::MakeWithCopy(source.data(), source.size());
+    ++texture_stats.copied_textures;
+  } else {
+    data = SkData::MakeUninitialized(source.size());
+    if(data
+       && !sourcePixmap.readPixels(
+           SkPixmap(info, data->writable_data(), info.minRowBytes()))) {
+      data = nullptr;
+    }
+    ++texture_stats.copied_textures;
+  }
+
+  if(data) {
+    if(sk_sp<SkImage> img =
+           SkImage::MakeRasterData(info, std::move(data), info.minRowBytes())) {
+      TextureData* textureData = CreateTextureData(std::move(img));
+      textureData->glyph_atlas = true;
+      return reinterpret_cast<Rml::TextureHandle>(textureData);
+    }
+  }
+
+  return 0;
+}
+
+void SkiaRenderInterface::ReleaseTexture(Rml::TextureHandle texture_handle)
+{
+  FlushPending();
+
+  if(frame_deferred) {
+    PlayCommands();
+  }
+
+  auto* textureData = reinterpret_cast<TextureData*>(texture_handle);
+  InvalidatePictureUsing(textureData->id);
+  loading_textures.erase(textureData->id);
+  UnlinkTexture(*textureData);
+  texture_stats.resident_bytes -= textureData->bytes;
+  delete textureData;
+}
+
+void SkiaRenderInterface::EnableScissorRegion(bool enable)
+{
+  SetScissorState(enable, rect_scissor);
+}
+
+void SkiaRenderInterface::SetScissorRegion(Rml::Rectanglei region)
+{
+  SetScissorState(
+      scissor_region_enabled,
+      SkRect::Make(
+          {region.Left(), region.Top(), region.Right(), region.Bottom()}));
+}
+
+void SkiaRenderInterface::SetScissorState(bool enable, const SkRect& rect)
+{
+  // The region only matters while the scissor is enabled.
+  const bool changed = enable != scissor_region_enabled
+      || (enable && rect != rect_scissor);
+
+  if(changed) {
+    // The pending draws were queued with the previous scissor state.
+    FlushPending();
+  }
+
+  scissor_region_enabled = enable;
+  rect_scissor = rect;
+
+  if(changed) {
+    UpdateCullRect();
+  }
+}
+
+void SkiaRenderInterface::ApplyScissor()
+{
+  if(scissor_applied == scissor_region_enabled
+     && (!scissor_applied || applied_scissor == rect_scissor)) {
+    return;
+  }
+
+  ++frame_stats.scissor_changes;
+
+  // Clips only shrink, so the previous scissor is restored away rather than
+  // intersected with the new one.
+  ResetScissor();
+
+  if(scissor_region_enabled) {
+    scissor_save_count = draw_canvas->save();
+    draw_canvas->clipRect(rect_scissor);
+    applied_scissor = rect_scissor;
+    scissor_applied = true;
+  }
+}
+
+void SkiaRenderInterface::ResetScissor()
+{
+  if(scissor_applied) {
+    draw_canvas->restoreToCount(scissor_save_count);
+    scissor_applied = false;
   }
 }
@@ -31,21 +31,194 @@
 #ifndef SKIARMLBACKEND_SKIARENDERINTERFACE_H
 #define SKIARMLBACKEND_SKIARENDERINTERFACE_H
 
+#include "SkiaFrameArena.h"
+#include "SkiaTaskQueue.h"
+#include "SkiaTextureMemory.h"
+#include "SkiaThreadPool.h"
+
 #include <RmlUi/Core/RenderInterface.h>
 
 #include "include/core/SkCanvas.h"
+#include "include/core/SkColorType.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkMesh.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRSXform.h"
+#include "include/core/SkRegion.h"
+#include "include/core/SkSize.h"
+#include "include/core/SkVertices.h"
+
+#include <functional>
+#include <mutex>
 
 class SkiaRenderInterface : public Rml::RenderInterface
 {
 public:
-  SkiaRenderInterface(SkCanvas* canvas);
+  // Counters of the current frame, reset in BeginFrame().
+  struct FrameStats
+  {
+    // Geometry batches submitted by RenderGeometry().
+    int geometry_draws = 0;
+    // Geometry batches skipped because they lie outside the scissor region or
+    // the canvas.
+    int culled_geometry = 0;
+    // Geometry batches passed on to the draw paths.
+    int drawn_geometry = 0;
+    // Clip changes applied to the canvas, redundant scissor changes are
+    // skipped.
+    int scissor_changes = 0;
+    // Draw calls issued to the Skia canvas after batching.
+    int canvas_draws = 0;
+    // SkVertices built from RmlUi vertices, zero in a steady-state frame.
+    int vertex_builds = 0;
+    // Blocks allocated by the frame arena, zero once it has grown to fit the
+    // scratch memory of a frame. Skia allocates its own memory besides.
+    int arena_block_allocations = 0;
+  };
+
+  // Counters of the picture cache since it was last enabled.
+  struct PictureCacheStats
+  {
+    // Frames drawn from the cached picture.
+    int hits = 0;
+    // Frames recorded into a new picture.
+    int misses = 0;
+    // Cached pictures dropped because a geometry or texture they draw was
+    // released.
+    int invalidations = 0;
+  };
+
+  // Counters of the textures loaded from encoded images.
+  struct TextureStats
+  {
+    // Textures decoded lazily on draw by the Skia codecs.
+    int encoded_textures = 0;
+    // Decodes at a reduced size, for textures only drawn smaller than their
+    // full size.
+    int scaled_decodes = 0;
+    // Textures loaded on the loader threads and swapped in.
+    int async_loads = 0;
+    // Generated textures that took their memory from the texture memory as
+    // their pixels, and those that copied their pixels.
+    int adopted_textures = 0;
+    int copied_textures = 0;
+
+    // Bytes of the texture images, for lazily decoded images the bytes they
+    // decode to.
+    size_t resident_bytes = 0;
+    // Draws of textures loaded from files, with their image resident or
+    // evicted and loaded again.
+    uint64_t cache_hits = 0;
+    uint64_t cache_misses = 0;
+    // Textures evicted to keep the budget.
+    int evictions = 0;
+
+    double GetCacheHitRate() const;
+  };
+
+  // Called on a loader thread when a texture finished loading, for example
+  // to request the frame that swaps it in.
+  using TextureLoadedCallback = std::function<void(Rml::TextureHandle texture)>;
+
+  // How geometry is handed to Skia.
+  enum class GeometryPath
+  {
+    // SkVertices converted from the RmlUi vertices.
+    Vertices,
+    // SkMesh reading the RmlUi vertex layout as is, without conversion.
+    Mesh,
+  };
+
+  // Textures are created in colour types suiting 'color_type', the colour
+  // type of the canvas. 8888 canvases get textures in the same channel order
+  // so drawing them needs no swizzle, others get kN32_SkColorType textures.
+  // Opaque textures loaded for kRGB_565_SkColorType and kGray_8_SkColorType
+  // canvases are stored in the canvas colour type.
+  SkiaRenderInterface(
+      SkCanvas* canvas, SkColorType color_type = kN32_SkColorType);
 
   SkCanvas* getCanvas();
+  // Switches to another canvas between frames, keeping the compiled geometry
+  // and the textures. The next frame is drawn in full.
+  void SetCanvas(SkCanvas* canvas);
+  SkColorType GetTextureColorType() const;
+  SkColorType GetOpaqueTextureColorType() const;
 
   // Sets up OpenGL states for taking rendering commands from RmlUi.
   void BeginFrame();
+  // Flushes the pending batched draws to the canvas.
   void EndFrame();
 
+  // Consecutive draws of small geometry with the same texture and scissor
+  // state are merged into one canvas draw. Enabled by default.
+  void SetBatchingEnabled(bool enable);
+
+  // Selects the geometry path, Vertices by default. Returns false if the path
+  // is not available.
+  bool SetGeometryPath(GeometryPath path);
+  GeometryPath GetGeometryPath() const;
+
+  // Glyph runs, quads textured from a font atlas, are drawn with one
+  // SkCanvas::drawAtlas() call. Enabled by default.
+  void SetGlyphAtlasEnabled(bool enable);
+
+  // Frames are recorded into an SkPicture, and a frame with the same draws as
+  // the cached picture replays it without converting any geometry. Takes
+  // effect in the next BeginFrame(). Disabled by default.
+  void SetPictureCacheEnabled(bool enable);
+
+  // Frames are compared with the previous one, and only the regions covered
+  // by changed draws are cleared and redrawn. The surface must keep its
+  // pixels between frames. Takes effect in the next BeginFrame(). Disabled by
+  // default.
+  void SetDamageTrackingEnabled(bool enable);
+  // The regions of the canvas changed by the last frame, the whole canvas
+  // unless damage tracking is enabled.
+  const Rml::Vector<Rml::Rectanglei>& GetDamageRects() const;
+
+  // With more than one thread, frames are recorded into an SkPicture and
+  // played back in tiles on that many threads, straight into the pixels of
+  // the canvas. Needs a raster canvas with accessible pixels, other canvases
+  // are drawn on the calling thread. Takes effect in the next BeginFrame().
+  // One thread by default.
+  void SetRasterThreadCount(int count);
+
+  // All draws are dithered with Skia's ordered dither, hiding the banding of
+  // gradients on kRGB_565_SkColorType and kGray_8_SkColorType canvases. Takes
+  // effect in the next BeginFrame(). Disabled by default.
+  void SetDitheringEnabled(bool enable);
+
+  // With one or more threads, LoadTexture() returns at once with a
+  // transparent placeholder, and the file is read and decoded on that many
+  // loader threads. The texture replaces the placeholder in the first
+  // BeginFrame() after it is loaded. The size of a source is known once it
+  // was loaded, before that LoadTexture() reports zero dimensions, so the
+  // images should be sized by the document. Zero threads, the default, load
+  // synchronously.
+  void SetTextureLoadThreadCount(int count);
+  void SetTextureLoadedCallback(TextureLoadedCallback callback);
+
+  // At the end of a frame, textures loaded from files are evicted, least
+  // recently drawn first, while the resident bytes exceed 'bytes'. An evicted
+  // texture is loaded again from its file the next time it is drawn. The
+  // textures of the current frame and generated textures are not evicted.
+  // Zero, the default, sets no budget.
+  void SetTextureBudget(size_t bytes);
+
+  // Pixels passed to GenerateTexture() in memory allocated by
+  // 'texture_memory' become the pixels of the texture instead of being
+  // copied. Null, the default, copies all pixels. The texture memory is not
+  // owned and must outlive the render interface or be reset.
+  void SetTextureMemory(SkiaTextureMemory* texture_memory);
+  SkiaTextureMemory* GetTextureMemory() const;
+
+  const FrameStats& GetFrameStats() const;
+  const PictureCacheStats& GetPictureCacheStats() const;
+  const TextureStats& GetTextureStats() const;
+
   // -- Inherited from Rml::RenderInterface --
 
   Rml::CompiledGeometryHandle CompileGeometry(
@@ -68,15 +241,370 @@ public:
   void SetScissorRegion(Rml::Rectanglei region) override;
 
 private:
-  struct GeometryView
+  // The texture behind a texture handle.
+  struct TextureData
+  {
+    // Unique over the lifetime of the render interface, unlike the handle.
+    uint32_t id = 0;
+    sk_sp<SkImage> image;
+    // Paint with the image shader of 'image'.
+    SkPaint paint;
+    // Set for textures generated by RmlUi, its font engine generates them for
+    // the glyph atlases.
+    bool glyph_atlas = false;
+    // Set for textures loaded from an encoded image of the size
+    // 'encoded_size'. 'image' is then decoded lazily, or at a reduced size
+    // covering 'decoded_size', the largest size the texture was drawn at.
+    sk_sp<SkData> encoded;
+    SkISize encoded_size = {0, 0};
+    SkISize decoded_size = {0, 0};
+
+    // Set for textures loaded from a file, which the texture cache may evict
+    // and load again from 'source'.
+    Rml::String source;
+    bool evicted = false;
+    // Bytes of 'image' counted in the resident bytes.
+    size_t bytes = 0;
+    // The last frame the texture was drawn in, and the links of the list of
+    // cached textures, most recently drawn first. Evicted textures are not
+    // in the list.
+    uint64_t drawn_frame = 0;
+    TextureData* lru_prev = nullptr;
+    TextureData* lru_next = nullptr;
+  };
+
+  // A RenderGeometry() call of a frame with deferred draws, with the scissor
+  // state it was made in.
+  struct FrameCommand
+  {
+    Rml::CompiledGeometryHandle geometry;
+    Rml::Vector2f translation;
+    Rml::TextureHandle texture;
+    bool scissor_enabled;
+    // Empty if the scissor is disabled.
+    SkRect scissor;
+
+    // Commands are compared by the geometry and texture ids, the handles may
+    // be reused after a release.
+    uint32_t geometry_id;
+    uint32_t texture_id;
+    // The visible bounds on the canvas.
+    SkRect bounds;
+
+    bool operator==(const FrameCommand& other) const;
+    uint64_t Hash(uint64_t hash) const;
+  };
+
+  // An axis-aligned rectangle with one colour, made of two triangles.
+  struct GeometryQuad
+  {
+    SkRect rect;
+    // Normalized texture coordinates of the rectangle corners.
+    SkRect tex_rect;
+    SkColor color;
+  };
+
+  // SkVertices takes 16-bit indices only, so meshes with more vertices are
+  // split into batches at compile time.
+  struct GeometryBatch
   {
+    // Unique over the lifetime of the render interface, identifies the batch
+    // in the merged vertices.
+    uint32_t id = 0;
+    // Points to the RmlUi vertex data if the mesh is not split, or to
+    // 'split_vertices' otherwise. RmlUi keeps its data alive until
+    // ReleaseGeometry().
     Rml::Span<const Rml::Vertex> vertices;
-    Rml::Span<const int> indices;
+    Rml::Vector<Rml::Vertex> split_vertices;
+    Rml::Vector<uint16_t> indices;
+    SkRect bounds = SkRect::MakeEmpty();
+
+    // Set at compile time if the batch is a list of axis-aligned quads, as
+    // RmlUi generates for backgrounds, borders, images and glyphs.
+    Rml::Vector<GeometryQuad> quads;
+    // Set if all vertices have the same colour 'color'.
+    bool uniform_color = false;
+    SkColor color = SK_ColorTRANSPARENT;
+
+    // Vertices without texture coordinates, built by the first untextured
+    // draw through drawVertices().
+    sk_sp<SkVertices> sk_vertices;
+
+    // Vertices with texture coordinates in the pixel space of the texture
+    // with the size 'texture_size', rebuilt when a texture with another size
+    // is bound.
+    sk_sp<SkVertices> sk_textured_vertices;
+    SkISize texture_size = {0, 0};
+
+    // Mesh path: the buffers hold the RmlUi vertices as they are. The meshes
+    // differ in the texture size uniform only, like the vertices above.
+    sk_sp<SkMesh::VertexBuffer> mesh_vertex_buffer;
+    sk_sp<SkMesh::IndexBuffer> mesh_index_buffer;
+    SkMesh mesh;
+    SkMesh textured_mesh;
+    SkISize mesh_texture_size = {0, 0};
+
+    // Glyph atlas path: a sprite per quad in the pixel space of the atlas with
+    // the size 'atlas_texture_size'. Empty if a quad is not drawn at the same
+    // scale along both axes, which drawAtlas() can not express.
+    Rml::Vector<SkRSXform> atlas_xforms;
+    Rml::Vector<SkRect> atlas_rects;
+    Rml::Vector<SkColor> atlas_colors;
+    SkISize atlas_texture_size = {0, 0};
+  };
+
+  struct CompiledGeometry
+  {
+    // Unique over the lifetime of the render interface, unlike the handle.
+    uint32_t id = 0;
+    SkRect bounds = SkRect::MakeEmpty();
+    // The size a texture is drawn at by the geometry, the largest of its
+    // triangles from their span of the texture coordinates. Zero along an
+    // axis without a span.
+    SkISize texture_draw_size = {0, 0};
+    Rml::Vector<GeometryBatch> batches;
   };
 
+  void DrawGeometry(
+      CompiledGeometry& geometry,
+      Rml::Vector2f translation,
+      Rml::TextureHandle texture);
+
+  void RecordCommand(const FrameCommand& command);
+  void BeginRecording();
+  void PlayCommand(const FrameCommand& command);
+  void PlayCommands();
+  void PlayCommands(const FrameCommand* list, int count);
+  void PresentDeferredFrame();
+  void ComputeDamage(bool unchanged);
+  bool DrawPictureTiled(const SkPicture* picture, bool clip_to_damage);
+  void InvalidatePicture();
+  void InvalidatePictureUsing(uint32_t resource_id);
+
+  void SetScissorState(bool enable, const SkRect& rect);
+  void ApplyScissor();
+  void ResetScissor();
+  void UpdateCullRect();
+  bool IsCulled(const GeometryBatch& batch, Rml::Vector2f translation) const;
+
+  TextureData* CreateTextureData(sk_sp<SkImage> image);
+  sk_sp<SkImage> GetPlaceholderImage();
+  // Decodes a TGA file to an image of the texture colour type.
+  sk_sp<SkImage> DecodeTgaTexture(const SkData& file_data) const;
+  // Loads the image of a file, 'encoded' receives the file data if the image
+  // is decoded lazily.
+  sk_sp<SkImage> LoadTextureImage(
+      const Rml::String& source, sk_sp<SkData>& encoded) const;
+
+  Rml::TextureHandle LoadTextureAsync(
+      Rml::Vector2i& texture_dimensions, const Rml::String& source);
+  // Runs on a loader thread.
+  void LoadTextureTask(
+      uint32_t texture_id, Rml::TextureHandle texture, const Rml::String& source);
+  // Replaces the placeholders of the loaded textures.
+  void SwapLoadedTextures();
+
+  // Texture cache: textures loaded from files are linked into the list of
+  // cached textures, moved to its front when drawn and evicted from its back.
+  void AddCachedTexture(TextureData& texture, const Rml::String& source);
+  void UseCachedTexture(TextureData& texture);
+  void ReloadTexture(TextureData& texture);
+  void EvictTextures();
+  void LinkTexture(TextureData& texture);
+  void UnlinkTexture(TextureData& texture);
+  void UpdateTextureBytes(TextureData& texture);
+
+  // Decodes an encoded texture again if it is drawn larger than decoded.
+  void UpdateDecodedSize(TextureData& texture, SkISize draw_size);
+  static const SkPaint* GetTexturePaint(Rml::TextureHandle texture);
+  // Returns 'paint', or the default paint if null, dithered if enabled.
+  const SkPaint& GetDrawPaint(const SkPaint* paint);
+  // Returns the paint of untextured draws in 'color', dithered if enabled.
+  const SkPaint& GetColorPaint(SkColor color);
+
+  static void SplitGeometry(
+      Rml::Span<const Rml::Vertex> vertices,
+      Rml::Span<const int> indices,
+      Rml::Vector<GeometryBatch>& batches);
+  static void ClassifyBatch(GeometryBatch& batch);
+  static bool OmitsColors(const GeometryBatch& batch, const SkImage* image);
+  static sk_sp<SkVertices> MakeVertices(
+      const GeometryBatch& batch, const SkImage* image);
+
+  static void MakeAtlasSprites(GeometryBatch& batch, const SkImage* image);
+  bool DrawAtlas(
+      GeometryBatch& batch,
+      Rml::Vector2f translation,
+      const SkImage* image);
+
+  bool DrawQuads(
+      const GeometryBatch& batch,
+      Rml::Vector2f translation,
+      const SkImage* image);
+
+  void DrawBatch(
+      GeometryBatch& batch,
+      Rml::Vector2f translation,
+      const SkPaint* paint,
+      const SkImage* image);
+  void DrawVertices(const SkVertices* vertices, const SkPaint* paint);
+
+  static bool MakeMeshBuffers(GeometryBatch& batch);
+  SkMesh MakeMesh(const GeometryBatch& batch, const SkImage* image) const;
+  void DrawMeshBatch(
+      GeometryBatch& batch,
+      Rml::Vector2f translation,
+      const SkPaint* paint,
+      const SkImage* image);
+
+  void QueueBatch(
+      GeometryBatch& batch,
+      Rml::Vector2f translation,
+      Rml::TextureHandle texture,
+      const SkImage* image);
+  void FlushPending();
+  sk_sp<SkVertices> MakeMergedVertices() const;
+  void EvictMergedVertices();
+
   SkCanvas* canvas_;
+  SkColorType texture_color_type;
+  SkColorType opaque_texture_color_type;
+  // The canvas the draw paths draw to, 'canvas_' or the picture recorder.
+  SkCanvas* draw_canvas;
+  // The scissor state requested by RmlUi. It is applied to the canvas when
+  // the next geometry is drawn, as a clip saved on top of the canvas state.
   SkRect rect_scissor = {};
   bool scissor_region_enabled = false;
+  // The scissor clip on the canvas, restored to 'scissor_save_count'.
+  SkRect applied_scissor = {};
+  bool scissor_applied = false;
+  int scissor_save_count = 0;
+  // The visible part of the canvas, the scissor region if enabled.
+  SkRect cull_rect = {};
+
+  bool batching_enabled = true;
+  bool glyph_atlas_enabled = true;
+  bool dithering_enabled = false;
+  // The paint of the draws without a texture, and the dithered copy of the
+  // last paint returned by GetDrawPaint().
+  SkPaint default_paint;
+  SkPaint dither_paint;
+  // The paint returned by GetColorPaint().
+  SkPaint color_paint;
+  GeometryPath geometry_path = GeometryPath::Vertices;
+  sk_sp<SkMeshSpecification> mesh_specification;
+  FrameStats frame_stats;
+
+  struct QueuedDraw
+  {
+    GeometryBatch* batch;
+    Rml::Vector2f translation;
+  };
+
+  // A draw merged into the merged vertices.
+  struct MergedDraw
+  {
+    uint32_t batch_id;
+    Rml::Vector2f translation;
+  };
+
+  // The vertices of merged draws, drawn again as long as the same batches
+  // are merged at the same translations with a texture of the same size.
+  struct MergedVertices
+  {
+    Rml::Vector<MergedDraw> draws;
+    SkISize texture_size = {0, 0};
+    sk_sp<SkVertices> vertices;
+    // The last frame that drew the vertices.
+    uint64_t drawn_frame = 0;
+  };
+
+  // Scratch memory of the current frame, reset in BeginFrame().
+  SkiaFrameArena frame_arena;
+
+  // Draws queued for merging, allocated from the frame arena. A single queued
+  // draw is drawn from its compiled batch without conversion if nothing is
+  // merged with it.
+  QueuedDraw* pending = nullptr;
+  int pending_capacity = 0;
+  int pending_draws = 0;
+  size_t pending_vertices = 0;
+  size_t pending_indices = 0;
+  Rml::TextureHandle pending_texture = 0;
+  const SkImage* pending_image = nullptr;
+
+  // Merged vertices by the hash of their draws. The vertices a frame with
+  // merged draws did not draw are dropped at its end.
+  Rml::UnorderedMap<uint64_t, MergedVertices> merged_vertices;
+  uint64_t merged_frame = 0;
+
+  bool picture_cache_enabled = false;
+  PictureCacheStats picture_cache_stats;
+  TextureStats texture_stats;
+
+  // A texture loaded on a loader thread, null if it failed to load.
+  struct LoadedTexture
+  {
+    uint32_t texture_id;
+    Rml::String source;
+    sk_sp<SkImage> image;
+  };
+
+  size_t texture_budget = 0;
+  SkiaTextureMemory* texture_memory = nullptr;
+  TextureData* lru_head = nullptr;
+  TextureData* lru_tail = nullptr;
+  // Counts the frames, for the textures drawn in the current frame.
+  uint64_t frame_number = 0;
+
+  // Placeholders by texture id, until their texture is swapped in.
+  Rml::UnorderedMap<uint32_t, TextureData*> loading_textures;
+  // The sizes of the sources loaded so far.
+  Rml::UnorderedMap<Rml::String, Rml::Vector2i> loaded_texture_sizes;
+  sk_sp<SkImage> placeholder_image;
+
+  // Shared with the loader threads.
+  std::mutex loaded_mutex;
+  Rml::Vector<LoadedTexture> loaded_textures;
+  TextureLoadedCallback texture_loaded_callback;
+
+  bool damage_tracking_enabled = false;
+  SkRegion damage_region;
+  Rml::Vector<Rml::Rectanglei> damage_rects;
+
+  // Runs the tiled playback, null if frames are drawn on the calling thread.
+  Rml::UniquePtr<SkiaThreadPool> raster_threads;
+
+  // The next id of a compiled geometry, geometry batch or texture.
+  uint32_t next_resource_id = 1;
+
+  // Set in BeginFrame() if the draws of the frame are deferred to EndFrame().
+  bool frame_deferred = false;
+  // The commands of the frame, allocated from the frame arena, and their
+  // hash. Commands before 'played_commands' are already recorded into the
+  // picture, they are played early when a geometry or texture is released.
+  FrameCommand* commands = nullptr;
+  int command_capacity = 0;
+  int command_count = 0;
+  int played_commands = 0;
+  uint64_t command_hash = 0;
+  // Cleared if the command list ran out of memory and lost commands.
+  bool commands_complete = true;
+
+  SkPictureRecorder picture_recorder;
+  bool picture_recording = false;
+
+  // The commands of the previous deferred frame, and its picture if the
+  // picture cache is enabled.
+  Rml::Vector<FrameCommand> previous_commands;
+  uint64_t previous_hash = 0;
+  SkISize previous_size = {0, 0};
+  bool previous_frame_valid = false;
+  sk_sp<SkPicture> cached_picture;
+
+  // Declared last, the loader threads use the members above until they are
+  // joined.
+  Rml::UniquePtr<SkiaTaskQueue> texture_loader;
 };
 
 #endif  // SKIARMLBACKEND_SKIARENDERINTERFACE_H
@@ -0,0 +1,97 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+
+#ifndef SKIARMLBACKEND_SKIASPSCQUEUE_H
+#define SKIARMLBACKEND_SKIASPSCQUEUE_H
+
+#include <RmlUi/Core/Types.h>
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue between one producer and one consumer thread.
+template<typename T>
+class SkiaSpscQueue
+{
+public:
+  explicit SkiaSpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+  SkiaSpscQueue(const SkiaSpscQueue&) = delete;
+  SkiaSpscQueue& operator=(const SkiaSpscQueue&) = delete;
+
+  // Producer only. Returns false if the queue is full.
+  bool Push(const T& value)
+  {
+    const size_t write = write_index.load(std::memory_order_relaxed);
+    const size_t next = Next(write);
+    if(next == read_index.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    slots[write] = value;
+    write_index.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false if the queue is empty.
+  bool Pop(T& value)
+  {
+    const size_t read = read_index.load(std::memory_order_relaxed);
+    if(read == write_index.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    value = slots[read];
+    read_index.store(Next(read), std::memory_order_release);
+    return true;
+  }
+
+  bool IsEmpty() const
+  {
+    return read_index.load(std::memory_order_acquire)
+        == write_index.load(std::memory_order_acquire);
+  }
+
+private:
+  size_t Next(size_t index) const
+  {
+    return index + 1 == slots.size() ? 0 : index + 1;
+  }
+
+  // One slot stays free to tell a full queue from an empty one.
+  Rml::Vector<T> slots;
+
+  // On separate cache lines, each is written by one thread only.
+  alignas(64) std::atomic<size_t> write_index {0};
+  alignas(64) std::atomic<size_t> read_index {0};
+};
+
+#endif  // SKIARMLBACKEND_SKIASPSCQUEUE_H
@@ -0,0 +1,69 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#ifndef SKIARMLBACKEND_SKIATASKQUEUE_H
+#define SKIARMLBACKEND_SKIATASKQUEUE_H
+
+#include <RmlUi/Core/Types.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Worker threads running queued tasks in the order they were pushed.
+class SkiaTaskQueue
+{
+public:
+  explicit SkiaTaskQueue(int thread_count);
+  // Runs the queued tasks to the end before the workers exit.
+  ~SkiaTaskQueue();
+
+  SkiaTaskQueue(const SkiaTaskQueue&) = delete;
+  SkiaTaskQueue& operator=(const SkiaTaskQueue&) = delete;
+
+  int GetThreadCount() const;
+
+  void Push(std::function<void()> task);
+
+private:
+  void WorkerLoop();
+
+  Rml::Vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  // Guarded by 'mutex'.
+  std::deque<std::function<void()>> tasks;
+  bool stopping = false;
+};
+
+#endif  // SKIARMLBACKEND_SKIATASKQUEUE_H
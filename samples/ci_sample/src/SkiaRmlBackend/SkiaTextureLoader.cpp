@@ -0,0 +1,348 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#include "SkiaTextureLoader.h"
+
+#include "SkiaKernels.h"
+
+#include <RmlUi/Core/Core.h>
+#include <RmlUi/Core/FileInterface.h>
+#include <RmlUi/Core/Log.h>
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkImageInfo.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+// Set to byte packing, or the compiler will expand our struct, which means it
+// won't match the file.
+#pragma pack(push, 1)
+struct TGAHeader
+{
+  uint8_t idLength;
+  uint8_t colourMapType;
+  uint8_t dataType;
+  uint16_t colourMapOrigin;
+  uint16_t colourMapLength;
+  uint8_t colourMapDepth;
+  uint16_t xOrigin;
+  uint16_t yOrigin;
+  uint16_t width;
+  uint16_t height;
+  uint8_t bitsPerPixel;
+  uint8_t imageDescriptor;
+};
+// Restore packing.
+#pragma pack(pop)
+
+static_assert(sizeof(TGAHeader) == 18);
+
+static constexpr uint8_t TGA_UNCOMPRESSED = 2;
+static constexpr uint8_t TGA_RLE = 10;
+static constexpr uint8_t TGA_TOP_ORIGIN = 32;
+
+static sk_sp<SkData> ReadFile(const Rml::String& source)
+{
+  Rml::FileInterface* file_interface = Rml::GetFileInterface();
+  Rml::FileHandle file_handle = file_interface->Open(source);
+  if(!file_handle) {
+    return nullptr;
+  }
+
+  file_interface->Seek(file_handle, 0, SEEK_END);
+  size_t size = file_interface->Tell(file_handle);
+  file_interface->Seek(file_handle, 0, SEEK_SET);
+
+  sk_sp<SkData> data = SkData::MakeUninitialized(size);
+  size_t read_cnt =
+      file_interface->Read(data->writable_data(), size, file_handle);
+  file_interface->Close(file_handle);
+
+  if(read_cnt < size) {
+    return nullptr;
+  }
+  return data;
+}
+
+sk_sp<SkData> SkiaTextureLoader::LoadFile(const Rml::String& source)
+{
+  // The mapping is not copied, the decoder reads the pages of the file.
+  sk_sp<SkData> data = SkData::MakeFromFileName(source.c_str());
+  if(!data) {
+    data = ReadFile(source);
+  }
+
+  if(!data) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR, "Could not load texture file '%s'.",
+        source.c_str());
+  }
+  return data;
+}
+
+// Writes decoded pixels to the bitmap rows in image order, whatever the row
+// order of the file is.
+class TgaPixelWriter
+{
+public:
+  TgaPixelWriter(SkBitmap& bitmap, bool top_origin, bool dest_rgba)
+      : bitmap(bitmap)
+      , width(bitmap.width())
+      , height(bitmap.height())
+      , top_origin(top_origin)
+      , dest_rgba(dest_rgba)
+  {
+  }
+
+  int GetRemaining() const { return width * height - position; }
+  bool IsOpaque() const { return opaque; }
+
+  // Converts 'count' pixels of 'source_bytes' bytes each.
+  void WritePixels(const Rml::byte* source, int source_bytes, int count)
+  {
+    while(count > 0) {
+      const int x = position % width;
+      const int n = std::min(count, width - x);
+
+      opaque = SkiaKernels::ConvertTgaPixels(
+                   source, source_bytes, n, dest_rgba, GetDest(x))
+          && opaque;
+
+      source += n * source_bytes;
+      position += n;
+      count -= n;
+    }
+  }
+
+  // Converts one pixel and repeats it 'count' times.
+  void WriteRun(const Rml::byte* source, int source_bytes, int count)
+  {
+    Rml::byte pixel[4];
+    opaque = SkiaKernels::ConvertTgaPixels(
+                 source, source_bytes, 1, dest_rgba, pixel)
+        && opaque;
+
+    while(count > 0) {
+      const int x = position % width;
+      const int n = std::min(count, width - x);
+
+      Rml::byte* dest = GetDest(x);
+      for(int i = 0; i < n; ++i) {
+        std::memcpy(dest + i * 4, pixel, 4);
+      }
+
+      position += n;
+      count -= n;
+    }
+  }
+
+private:
+  Rml::byte* GetDest(int x) const
+  {
+    const int y = position / width;
+    const int row = top_origin ? y : height - y - 1;
+    return static_cast<Rml::byte*>(bitmap.getPixels())
+        + row * bitmap.rowBytes() + x * 4;
+  }
+
+  SkBitmap& bitmap;
+  const int width;
+  const int height;
+  const bool top_origin;
+  const bool dest_rgba;
+
+  int position = 0;
+  bool opaque = true;
+};
+
+static bool DecodeRle(
+    const Rml::byte* data, size_t size, int pixel_bytes, TgaPixelWriter& writer)
+{
+  size_t offset = 0;
+
+  while(writer.GetRemaining() > 0) {
+    if(offset >= size) {
+      return false;
+    }
+
+    // The low 7 bits of the packet header are the pixel count minus 1, the
+    // high bit marks a run of one repeated pixel.
+    const Rml::byte packet = data[offset++];
+    const int count = std::min((packet & 0x7F) + 1, writer.GetRemaining());
+    const bool run = (packet & 0x80) != 0;
+
+    const size_t packet_bytes = size_t(run ? 1 : count) * pixel_bytes;
+    if(size - offset < packet_bytes) {
+      return false;
+    }
+
+    if(run) {
+      writer.WriteRun(data + offset, pixel_bytes, count);
+    } else {
+      writer.WritePixels(data + offset, pixel_bytes, count);
+    }
+    offset += packet_bytes;
+  }
+
+  return true;
+}
+
+bool SkiaTextureLoader::DecodeTga(
+    const void* data,
+    size_t size,
+    SkColorType color_type,
+    SkBitmap& bitmap,
+    bool& opaque)
+{
+  RMLUI_ASSERT(
+      color_type == SkColorType::kRGBA_8888_SkColorType
+      || color_type == SkColorType::kBGRA_8888_SkColorType);
+
+  if(size <= sizeof(TGAHeader)) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR,
+        "Texture file size is smaller than TGAHeader, file is not a valid TGA image.");
+    return false;
+  }
+
+  TGAHeader header;
+  std::memcpy(&header, data, sizeof(TGAHeader));
+
+  if(header.dataType != TGA_UNCOMPRESSED && header.dataType != TGA_RLE) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR,
+        "Only 24/32bit uncompressed or RLE-compressed TGAs are supported.");
+    return false;
+  }
+
+  const int pixel_bytes = header.bitsPerPixel / 8;
+  if(pixel_bytes != 3 && pixel_bytes != 4) {
+    Rml::Log::Message(
+        Rml::Log::LT_ERROR, "Only 24 and 32bit textures are supported.");
+    return false;
+  }
+
+  // Skip the image ID and the colour map, which true-colour images may have.
+  const size_t colour_map_bytes = header.colourMapType != 0
+      ? size_t(header.colourMapLength) * ((header.colourMapDepth + 7) / 8)
+      : 0;
+  const size_t offset = sizeof(TGAHeader) + header.idLength + colour_map_bytes;
+
+  const int width = header.width;
+  const int height = header.height;
+  const size_t pixel_count = size_t(width) * height;
+
+  if(offset > size
+     || (header.dataType == TGA_UNCOMPRESSED
+         && (size - offset) / pixel_bytes < pixel_count)) {
+    Rml::Log::Message(Rml::Log::LT_ERROR, "TGA image data is truncated.");
+    return false;
+  }
+
+  // The pixel writer counts the pixels in int.
+  if(pixel_count > size_t(INT_MAX)) {
+    Rml::Log::Message(Rml::Log::LT_ERROR, "TGA image is too large.");
+    return false;
+  }
+
+  if(!bitmap.tryAllocPixels(SkImageInfo::Make(
+         width, height, color_type, SkAlphaType::kPremul_SkAlphaType))) {
+    return false;
+  }
+
+  const auto* pixels = static_cast<const Rml::byte*>(data) + offset;
+  const bool top_origin = (header.imageDescriptor & TGA_TOP_ORIGIN) != 0;
+  const bool dest_rgba = color_type == SkColorType::kRGBA_8888_SkColorType;
+
+  if(pixel_count == 0) {
+    opaque = true;
+    return true;
+  }
+
+  TgaPixelWriter writer(bitmap, top_origin, dest_rgba);
+
+  if(header.dataType == TGA_UNCOMPRESSED) {
+    writer.WritePixels(pixels, pixel_bytes, int(pixel_count));
+  } else if(!DecodeRle(pixels, size - offset, pixel_bytes, writer)) {
+    Rml::Log::Message(Rml::Log::LT_ERROR, "TGA image data is truncated.");
+    bitmap.reset();
+    return false;
+  }
+
+  opaque = writer.IsOpaque();
+  return true;
+}
+
+sk_sp<SkImage> SkiaTextureLoader::MakeLazyImage(sk_sp<SkData> data)
+{
+  // Only the header is read here, TGA data is not taken by any codec.
+  return SkImage::MakeFromEncoded(std::move(data));
+}
+
+sk_sp<SkImage> SkiaTextureLoader::DecodeScaledImage(
+    const sk_sp<SkData>& data, SkISize size, SkColorType color_type)
+{
+  std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+  if(!codec || size.isEmpty()) {
+    return nullptr;
+  }
+
+  const SkISize full_size = codec->dimensions();
+  const float scale = std::max(
+      static_cast<float>(size.width()) / full_size.width(),
+      static_cast<float>(size.height()) / full_size.height());
+
+  // The codec may round the scale either way, a smaller image than 'size'
+  // would be magnified on draw.
+  const SkISize scaled_size = codec->getScaledDimensions(scale);
+  if(scaled_size == full_size || scaled_size.width() < size.width()
+     || scaled_size.height() < size.height()) {
+    return nullptr;
+  }
+
+  SkBitmap bitmap;
+  if(!bitmap.tryAllocPixels(SkImageInfo::Make(
+         scaled_size, color_type, SkAlphaType::kPremul_SkAlphaType))) {
+    return nullptr;
+  }
+
+  const SkCodec::Result result = codec->getPixels(bitmap.pixmap());
+  if(result != SkCodec::kSuccess && result != SkCodec::kIncompleteInput) {
+    return nullptr;
+  }
+
+  bitmap.setImmutable();
+  return bitmap.asImage();
+}
@@ -0,0 +1,82 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#ifndef SKIARMLBACKEND_SKIATEXTURELOADER_H
+#define SKIARMLBACKEND_SKIATEXTURELOADER_H
+
+#include <RmlUi/Core/Types.h>
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorType.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSize.h"
+
+#include <cstddef>
+
+// Loading of texture files for SkiaRenderInterface.
+namespace SkiaTextureLoader
+{
+
+// Returns the contents of the file 'source'. The file is memory-mapped if
+// possible, otherwise it is read through the RmlUi file interface.
+// @return Null on error.
+sk_sp<SkData> LoadFile(const Rml::String& source);
+
+// Decodes an uncompressed (type 2) or RLE-compressed (type 10) 24 or 32 bit
+// TGA image to premultiplied pixels of 'color_type', which is
+// kRGBA_8888_SkColorType or kBGRA_8888_SkColorType.
+// @param opaque Receives true if all pixels are opaque.
+// @return False with a logged error if the image is not supported.
+bool DecodeTga(
+    const void* data,
+    size_t size,
+    SkColorType color_type,
+    SkBitmap& bitmap,
+    bool& opaque);
+
+// Returns an image decoded lazily from the file contents 'data' on its first
+// draw, if the data is in a format of the Skia codecs: PNG, JPEG, WebP, GIF
+// and the others Skia is built with.
+// @return Null if no codec takes the data.
+sk_sp<SkImage> MakeLazyImage(sk_sp<SkData> data);
+
+// Decodes 'data' at the smallest size the codec can scale to that still
+// covers 'size', to premultiplied pixels of 'color_type'. Only JPEG and WebP
+// decode at reduced sizes.
+// @return Null if the codec can not decode the image smaller than its full
+// size.
+sk_sp<SkImage> DecodeScaledImage(
+    const sk_sp<SkData>& data, SkISize size, SkColorType color_type);
+
+}  // namespace SkiaTextureLoader
+
+#endif  // SKIARMLBACKEND_SKIATEXTURELOADER_H
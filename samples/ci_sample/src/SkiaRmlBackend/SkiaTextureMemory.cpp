@@ -0,0 +1,70 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#include "SkiaTextureMemory.h"
+
+Rml::Span<Rml::byte> SkiaTextureMemory::AllocateTexture(
+    Rml::Vector2i dimensions)
+{
+  if(dimensions.x <= 0 || dimensions.y <= 0) {
+    return {};
+  }
+
+  const size_t size = size_t(dimensions.x) * size_t(dimensions.y) * 4;
+  sk_sp<SkData> data = SkData::MakeUninitialized(size);
+  if(!data) {
+    return {};
+  }
+
+  auto* pixels = static_cast<Rml::byte*>(data->writable_data());
+  std::lock_guard<std::mutex> lock(mutex);
+  allocations[pixels] = std::move(data);
+  return {pixels, size};
+}
+
+void SkiaTextureMemory::ReleaseTexture(Rml::Span<Rml::byte> data)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  allocations.erase(data.data());
+}
+
+sk_sp<SkData> SkiaTextureMemory::TakeTexture(Rml::Span<const Rml::byte> pixels)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto it = allocations.find(pixels.data());
+  if(it == allocations.end() || it->second->size() != pixels.size()) {
+    return nullptr;
+  }
+
+  sk_sp<SkData> data = std::move(it->second);
+  allocations.erase(it);
+  return data;
+}
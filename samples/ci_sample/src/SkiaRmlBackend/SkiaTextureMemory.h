@@ -0,0 +1,63 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#ifndef SKIARMLBACKEND_SKIATEXTUREMEMORY_H
+#define SKIARMLBACKEND_SKIATEXTUREMEMORY_H
+
+#include "RmlUiFontEngineDefault/FontTextureAllocator.h"
+
+#include <RmlUi/Core/Types.h>
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+
+#include <mutex>
+
+// Memory of the textures generated by the font engine, allocated as SkData.
+// A render interface with this texture memory takes the memory as the pixels
+// of the texture generated from it, instead of copying them. Shared by the
+// render interfaces, which may generate textures on different threads.
+class SkiaTextureMemory : public Rml::FontTextureAllocator
+{
+public:
+  Rml::Span<Rml::byte> AllocateTexture(Rml::Vector2i dimensions) override;
+  void ReleaseTexture(Rml::Span<Rml::byte> data) override;
+
+  // Returns the memory of 'pixels' if it is allocated here and was neither
+  // taken nor released, null otherwise.
+  sk_sp<SkData> TakeTexture(Rml::Span<const Rml::byte> pixels);
+
+private:
+  std::mutex mutex;
+  // The allocations by the address of their memory.
+  Rml::UnorderedMap<const void*, sk_sp<SkData>> allocations;
+};
+
+#endif  // SKIARMLBACKEND_SKIATEXTUREMEMORY_H
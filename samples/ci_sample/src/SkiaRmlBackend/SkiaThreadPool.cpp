@@ -0,0 +1,123 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#include "SkiaThreadPool.h"
+
+SkiaThreadPool::SkiaThreadPool(int thread_count)
+{
+  for(int i = 1; i < thread_count; ++i) {
+    workers.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+SkiaThreadPool::~SkiaThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_condition.notify_all();
+
+  for(std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+int SkiaThreadPool::GetThreadCount() const
+{
+  return static_cast<int>(workers.size()) + 1;
+}
+
+void SkiaThreadPool::ParallelFor(
+    int count, const std::function<void(int)>& function)
+{
+  if(workers.empty() || count <= 1) {
+    for(int i = 0; i < count; ++i) {
+      function(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    loop_function = &function;
+    loop_count = count;
+    next_index = 0;
+    busy_workers = static_cast<int>(workers.size());
+    ++loop_generation;
+  }
+  work_condition.notify_all();
+
+  RunIterations(function, count);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_condition.wait(lock, [this]() { return busy_workers == 0; });
+  loop_function = nullptr;
+}
+
+void SkiaThreadPool::WorkerLoop()
+{
+  uint64_t generation = 0;
+
+  for(;;) {
+    const std::function<void(int)>* function;
+    int count;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      work_condition.wait(lock, [&]() {
+        return stopping || loop_generation != generation;
+      });
+
+      if(stopping) {
+        return;
+      }
+
+      generation = loop_generation;
+      function = loop_function;
+      count = loop_count;
+    }
+
+    RunIterations(*function, count);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(--busy_workers == 0) {
+      done_condition.notify_one();
+    }
+  }
+}
+
+void SkiaThreadPool::RunIterations(
+    const std::function<void(int)>& function, int count)
+{
+  for(int i = next_index++; i < count; i = next_index++) {
+    function(i);
+  }
+}
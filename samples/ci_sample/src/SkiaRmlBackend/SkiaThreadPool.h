@@ -0,0 +1,79 @@
+/*
+ * This source file is part of Skia RmlUi Backend.
+ *
+ * For the latest information, see https://github.com/LibCMaker/LibCMaker_RmlUi
+ *
+ * Copyright (c) 2025 NikitaFeodonit
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Skia RmlUi Backend
+
+
+#ifndef SKIARMLBACKEND_SKIATHREADPOOL_H
+#define SKIARMLBACKEND_SKIATHREADPOOL_H
+
+#include <RmlUi/Core/Types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Fixed set of worker threads running the iterations of a parallel loop
+// together with the calling thread.
+class SkiaThreadPool
+{
+public:
+  // Starts 'thread_count' - 1 workers, the calling thread is the last one.
+  explicit SkiaThreadPool(int thread_count);
+  ~SkiaThreadPool();
+
+  SkiaThreadPool(const SkiaThreadPool&) = delete;
+  SkiaThreadPool& operator=(const SkiaThreadPool&) = delete;
+
+  int GetThreadCount() const;
+
+  // Calls 'function' with every index in [0, count) on any of the threads and
+  // returns when all calls are done. Not reentrant.
+  void ParallelFor(int count, const std::function<void(int)>& function);
+
+private:
+  void WorkerLoop();
+  void RunIterations(const std::function<void(int)>& function, int count);
+
+  Rml::Vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable work_condition;
+  std::condition_variable done_condition;
+
+  // The loop being run, guarded by 'mutex' except for the next index.
+  const std::function<void(int)>* loop_function = nullptr;
+  int loop_count = 0;
+  std::atomic<int> next_index {0};
+  uint64_t loop_generation = 0;
+  int busy_workers = 0;
+  bool stopping = false;
+};
+
+#endif  // SKIARMLBACKEND_SKIATHREADPOOL_H
@@ -0,0 +1,705 @@
+/*****************************************************************************
+ * Project:  LibCMaker
+ * Purpose:  A CMake build scripts for build libraries with CMake
+ * Author:   NikitaFeodonit, nfeodonit@yandex.com
+ *****************************************************************************
+ *   Copyright (c) 2017-2025 NikitaFeodonit
+ *
+ *    This file is part of the LibCMaker project.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published
+ *    by the Free Software Foundation, either version 3 of the License,
+ *    or (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *    See the GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program. If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+
+#include <SkiaRmlBackend/SkiaBackend.h>
+#include <SkiaRmlBackend/SkiaKernels.h>
+#include <SkiaRmlBackend/SkiaRenderInterface.h>
+#include <SkiaRmlBackend/SkiaTextureLoader.h>
+
+#include <RmlUi/Core.h>
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkData.h"
+#include "include/core/SkPoint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+// Microbenchmarks of the render path. They check the results against the
+// reference implementation on every test run, and measure and print their
+// timings only if the SKIA_RML_BENCHMARK environment variable is set.
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+static bool IsBenchmarkEnabled()
+{
+  static const bool enabled = getenv("SKIA_RML_BENCHMARK") != nullptr;
+  return enabled;
+}
+
+static std::vector<Rml::Vertex> MakeRandomVertices(size_t count)
+{
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> position(0, 1000);
+  std::uniform_real_distribution<float> texCoord(0, 1);
+  std::uniform_int_distribution<int> channel(0, 255);
+
+  std::vector<Rml::Vertex> vertices(count);
+  for(Rml::Vertex& vertex : vertices) {
+    vertex.position = {position(random), position(random)};
+    vertex.colour = Rml::ColourbPremultiplied(
+        static_cast<Rml::byte>(channel(random)),
+        static_cast<Rml::byte>(channel(random)),
+        static_cast<Rml::byte>(channel(random)),
+        static_cast<Rml::byte>(channel(random)));
+    vertex.tex_coord = {texCoord(random), texCoord(random)};
+  }
+  return vertices;
+}
+
+// The per-vertex loop RenderGeometry() used before the conversion kernels.
+static void ConvertVerticesLoop(
+    const std::vector<Rml::Vertex>& vertices,
+    int imgWidth,
+    int imgHeight,
+    std::vector<SkPoint>& skPos,
+    std::vector<SkPoint>& skTex,
+    std::vector<SkColor>& skColor)
+{
+  skPos.clear();
+  skTex.clear();
+  skColor.clear();
+
+  for(const Rml::Vertex& vert : vertices) {
+    skPos.push_back(SkPoint::Make(vert.position.x, vert.position.y));
+    skTex.push_back(SkPoint::Make(
+        vert.tex_coord.x * imgWidth, vert.tex_coord.y * imgHeight));
+
+    skColor.push_back(SkiaKernels::ConvertColor(vert.colour));
+  }
+}
+
+template<typename Function>
+static double MeasureNsPerVertex(size_t vertexCount, Function function)
+{
+  // Roughly the same amount of work for every mesh size.
+  const int iterations = static_cast<int>(
+      Rml::Math::Max<size_t>(10, 20000000 / Rml::Math::Max<size_t>(1, vertexCount)));
+
+  function();  // Warm up.
+
+  auto start = BenchmarkClock::now();
+  for(int i = 0; i < iterations; ++i) {
+    function();
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      BenchmarkClock::now() - start;
+
+  return elapsed.count() / (static_cast<double>(iterations) * vertexCount);
+}
+
+TEST(Benchmark, ConvertVertices)
+{
+  using SkiaKernels::InstructionSet;
+
+  const int imgWidth = 512;
+  const int imgHeight = 256;
+  const Rml::Vector2f texScale = {
+      static_cast<float>(imgWidth), static_cast<float>(imgHeight)};
+
+  // SkColor is unpremultiplied, Skia premultiplies it once.
+  EXPECT_EQ(SkiaKernels::ConvertColor(Rml::ColourbPremultiplied(80, 40, 0, 160)),
+            SkColorSetARGB(160, 128, 64, 0));
+  EXPECT_EQ(SkiaKernels::ConvertColor(Rml::ColourbPremultiplied(0, 0, 0, 0)),
+            SkColorSetARGB(0, 0, 0, 0));
+  EXPECT_EQ(SkiaKernels::ConvertColor(Rml::ColourbPremultiplied(10, 20, 30, 255)),
+            SkColorSetARGB(255, 10, 20, 30));
+
+  struct Kernel
+  {
+    const char* name;
+    InstructionSet instruction_set;
+  };
+
+  const Kernel kernels[] = {
+      {"scalar", InstructionSet::Scalar},
+      {"SSE2", InstructionSet::SSE2},
+      {"AVX2", InstructionSet::AVX2},
+      {"NEON", InstructionSet::NEON},
+  };
+
+  for(size_t vertexCount : {1000, 10000, 100000}) {
+    const std::vector<Rml::Vertex> vertices = MakeRandomVertices(vertexCount);
+    const int count = static_cast<int>(vertexCount);
+
+    std::vector<SkPoint> loopPos;
+    std::vector<SkPoint> loopTex;
+    std::vector<SkColor> loopColor;
+
+    auto loop = [&]() {
+      ConvertVerticesLoop(
+          vertices, imgWidth, imgHeight, loopPos, loopTex, loopColor);
+    };
+    loop();
+
+    double loopNs = 0;
+    if(IsBenchmarkEnabled()) {
+      loopNs = MeasureNsPerVertex(vertexCount, loop);
+      printf("ConvertVertices %7zu vertices: loop   %6.2f ns/vertex\n",
+             vertexCount, loopNs);
+    }
+
+    std::vector<SkPoint> skPos(vertexCount);
+    std::vector<SkPoint> skTex(vertexCount);
+    std::vector<SkColor> skColor(vertexCount);
+
+    for(const Kernel& kernel : kernels) {
+      auto run = [&]() {
+        return SkiaKernels::ConvertVerticesWith(
+            kernel.instruction_set, vertices.data(), count, {0, 0}, texScale,
+            skPos.data(), skTex.data(), skColor.data());
+      };
+
+      if(!run()) {
+        continue;
+      }
+
+      EXPECT_EQ(0, memcmp(skPos.data(), loopPos.data(), vertexCount * sizeof(SkPoint)));
+      EXPECT_EQ(0, memcmp(skTex.data(), loopTex.data(), vertexCount * sizeof(SkPoint)));
+      EXPECT_EQ(0, memcmp(skColor.data(), loopColor.data(), vertexCount * sizeof(SkColor)));
+
+      if(IsBenchmarkEnabled()) {
+        double kernelNs = MeasureNsPerVertex(vertexCount, run);
+        printf("ConvertVertices %7zu vertices: %-6s %6.2f ns/vertex (x%.1f)\n",
+               vertexCount, kernel.name, kernelNs, loopNs / kernelNs);
+      }
+    }
+  }
+}
+
+template<typename Function>
+static double MeasureMsPerFrame(int frameCount, Function function)
+{
+  function();  // Warm up.
+
+  auto start = BenchmarkClock::now();
+  for(int i = 0; i < frameCount; ++i) {
+    function();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      BenchmarkClock::now() - start;
+
+  return elapsed.count() / frameCount;
+}
+
+TEST(Benchmark, GlyphAtlas)
+{
+  const int frameWidth = 490;
+  const int frameHeight = 500;
+  const int frameCount = IsBenchmarkEnabled() ? 200 : 1;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Glyph Atlas Benchmark", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  SkiaRenderInterface* skRmlRender =
+      static_cast<SkiaRenderInterface*>(SkiaBackend::GetRenderInterface());
+  Rml::SetRenderInterface(skRmlRender);
+
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::Context* rmlContext =
+      Rml::CreateContext("main", Rml::Vector2i(frameWidth, frameHeight));
+  ASSERT_TRUE(rmlContext);
+
+  Rml::LoadFontFace("assets/LatoLatin-Regular.ttf");
+  Rml::LoadFontFace("assets/LatoLatin-Bold.ttf");
+
+  Rml::ElementDocument* document = rmlContext->LoadDocument("assets/demo.rml");
+  ASSERT_TRUE(document);
+  document->Show();
+  rmlContext->Update();
+
+  auto renderFrame = [&]() {
+    SkiaBackend::BeginFrame();
+    rmlContext->Render();
+    SkiaBackend::PresentFrame();
+  };
+
+  skRmlRender->SetGlyphAtlasEnabled(false);
+  double verticesMs = MeasureMsPerFrame(frameCount, renderFrame);
+  int verticesDraws = skRmlRender->GetFrameStats().canvas_draws;
+
+  skRmlRender->SetGlyphAtlasEnabled(true);
+  double atlasMs = MeasureMsPerFrame(frameCount, renderFrame);
+  int atlasDraws = skRmlRender->GetFrameStats().canvas_draws;
+
+  if(IsBenchmarkEnabled()) {
+    printf("GlyphAtlas demo.rml: vertices %6.3f ms/frame, %d canvas draws\n",
+           verticesMs, verticesDraws);
+    printf("GlyphAtlas demo.rml: atlas    %6.3f ms/frame, %d canvas draws (x%.1f)\n",
+           atlasMs, atlasDraws, verticesMs / atlasMs);
+  }
+
+  EXPECT_GT(verticesDraws, 0);
+  EXPECT_GT(atlasDraws, 0);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+TEST(Benchmark, ColorType)
+{
+  const int frameWidth = 490;
+  const int frameHeight = 500;
+  const int frameCount = IsBenchmarkEnabled() ? 200 : 1;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Color Type Benchmark", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::LoadFontFace("assets/LatoLatin-Regular.ttf");
+  Rml::LoadFontFace("assets/LatoLatin-Bold.ttf");
+
+  struct ColorTypeRun
+  {
+    const char* name;
+    SkColorType color_type;
+    double ms = 0;
+  };
+  ColorTypeRun runs[] = {
+      {"RGBA", kRGBA_8888_SkColorType},
+      {"N32", kN32_SkColorType},
+  };
+
+  for(ColorTypeRun& run : runs) {
+    Rml::UniquePtr<SkiaBackend::Instance> instance =
+        SkiaBackend::Instance::Create(frameWidth, frameHeight, run.color_type);
+    ASSERT_TRUE(instance);
+    EXPECT_EQ(instance->GetColorType(), run.color_type);
+    EXPECT_EQ(
+        instance->GetRenderInterface()->GetTextureColorType(), run.color_type);
+
+    // Each instance has its own context, so the textures of the document are
+    // generated in the colour type of the instance.
+    const Rml::String contextName = Rml::String("color_type_") + run.name;
+    Rml::Context* rmlContext = Rml::CreateContext(
+        contextName, Rml::Vector2i(frameWidth, frameHeight),
+        instance->GetRenderInterface());
+    ASSERT_TRUE(rmlContext);
+
+    Rml::ElementDocument* document =
+        rmlContext->LoadDocument("assets/demo.rml");
+    ASSERT_TRUE(document);
+    document->Show();
+    rmlContext->Update();
+
+    run.ms = MeasureMsPerFrame(frameCount, [&]() {
+      instance->BeginFrame();
+      rmlContext->Render();
+      instance->PresentFrame();
+    });
+
+    EXPECT_GT(instance->GetRenderInterface()->GetFrameStats().canvas_draws, 0);
+
+    Rml::RemoveContext(contextName);
+    Rml::ReleaseRenderManagers();
+  }
+
+  if(IsBenchmarkEnabled()) {
+    printf("ColorType demo.rml: %-4s %6.3f ms/frame\n", runs[0].name,
+           runs[0].ms);
+    printf("ColorType demo.rml: %-4s %6.3f ms/frame (x%.2f)%s\n", runs[1].name,
+           runs[1].ms, runs[0].ms / runs[1].ms,
+           kN32_SkColorType == kRGBA_8888_SkColorType ? ", N32 is RGBA" : "");
+  }
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+TEST(Benchmark, ParallelPresentThroughput)
+{
+  const int frameWidth = 490;
+  const int frameHeight = 500;
+  const int documentCount = IsBenchmarkEnabled() ? 64 : 8;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Parallel Present Benchmark", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::LoadFontFace("assets/LatoLatin-Regular.ttf");
+  Rml::LoadFontFace("assets/LatoLatin-Bold.ttf");
+
+  // RmlUi is not thread-safe, its contexts share the global state of the
+  // library, so the documents are loaded, updated and rendered into the
+  // command lists under the lock. The picture cache defers the canvas work of
+  // a frame to PresentFrame(), which runs outside of it. The benchmark
+  // measures how the recording and playback of the instances scale with
+  // threads, the RmlUi work stays serialized.
+  std::mutex rmlMutex;
+
+  for(int threadCount : {1, 2, 4}) {
+    std::atomic<int> nextDocument {0};
+    std::atomic<int> renderedDocuments {0};
+
+    auto renderDocuments = [&](int threadIndex) {
+      Rml::UniquePtr<SkiaBackend::Instance> instance =
+          SkiaBackend::Instance::Create(frameWidth, frameHeight);
+      if(!instance) {
+        return;
+      }
+
+      SkiaRenderInterface* renderInterface = instance->GetRenderInterface();
+      renderInterface->SetPictureCacheEnabled(true);
+      // The font engine generates its textures in the memory of the backend.
+      renderInterface->SetTextureMemory(
+          static_cast<SkiaRenderInterface*>(SkiaBackend::GetRenderInterface())
+              ->GetTextureMemory());
+
+      const Rml::String contextName = "instance_"
+          + std::to_string(threadCount) + "_" + std::to_string(threadIndex);
+      Rml::Context* rmlContext;
+      {
+        std::lock_guard<std::mutex> lock(rmlMutex);
+        rmlContext = Rml::CreateContext(
+            contextName, Rml::Vector2i(frameWidth, frameHeight),
+            renderInterface);
+      }
+      if(!rmlContext) {
+        return;
+      }
+
+      while(nextDocument++ < documentCount) {
+        Rml::ElementDocument* document;
+        {
+          std::lock_guard<std::mutex> lock(rmlMutex);
+          document = rmlContext->LoadDocument("assets/demo.rml");
+          if(document) {
+            document->Show();
+            rmlContext->Update();
+            instance->BeginFrame();
+            rmlContext->Render();
+          }
+        }
+
+        if(!document) {
+          continue;
+        }
+
+        instance->PresentFrame();
+        ++renderedDocuments;
+
+        std::lock_guard<std::mutex> lock(rmlMutex);
+        document->Close();
+        rmlContext->Update();
+      }
+
+      // The render manager of the instance releases its geometry and
+      // textures before the instance is destroyed.
+      std::lock_guard<std::mutex> lock(rmlMutex);
+      Rml::RemoveContext(contextName);
+      Rml::ReleaseRenderManagers();
+    };
+
+    auto start = BenchmarkClock::now();
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < threadCount; ++i) {
+      threads.emplace_back(renderDocuments, i);
+    }
+    for(std::thread& thread : threads) {
+      thread.join();
+    }
+
+    std::chrono::duration<double> elapsed = BenchmarkClock::now() - start;
+
+    EXPECT_EQ(renderedDocuments, documentCount);
+    if(IsBenchmarkEnabled()) {
+      printf("ParallelPresentThroughput %d threads: %7.1f presented frames/s\n",
+             threadCount, renderedDocuments / elapsed.count());
+    }
+  }
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+static std::vector<Rml::byte> MakeRandomBytes(size_t count)
+{
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> channel(0, 255);
+
+  std::vector<Rml::byte> bytes(count);
+  for(Rml::byte& byte : bytes) {
+    byte = static_cast<Rml::byte>(channel(random));
+  }
+  return bytes;
+}
+
+TEST(Benchmark, ConvertTgaPixels)
+{
+  using SkiaKernels::InstructionSet;
+
+  struct Kernel
+  {
+    const char* name;
+    InstructionSet instruction_set;
+  };
+
+  const Kernel kernels[] = {
+      {"SSE2", InstructionSet::SSE2},
+      {"AVX2", InstructionSet::AVX2},
+      {"NEON", InstructionSet::NEON},
+  };
+
+  // Not a multiple of the vector widths, so the scalar tails run too.
+  const int count = 100003;
+
+  for(int sourceBytes : {3, 4}) {
+    std::vector<Rml::byte> source = MakeRandomBytes(count * sourceBytes);
+
+    for(bool destRgba : {false, true}) {
+      std::vector<Rml::byte> scalarDest(count * 4);
+      const bool scalarOpaque = SkiaKernels::ConvertTgaPixelsScalar(
+          source.data(), sourceBytes, count, destRgba, scalarDest.data());
+      EXPECT_EQ(sourceBytes == 3, scalarOpaque);
+
+      double scalarNs = 0;
+      if(IsBenchmarkEnabled()) {
+        scalarNs = MeasureNsPerVertex(count, [&]() {
+          SkiaKernels::ConvertTgaPixelsScalar(
+              source.data(), sourceBytes, count, destRgba, scalarDest.data());
+        });
+        printf("ConvertTgaPixels %d to %s: scalar %6.3f ns/pixel\n",
+               sourceBytes * 8, destRgba ? "RGBA" : "BGRA", scalarNs);
+      }
+
+      std::vector<Rml::byte> dest(count * 4);
+
+      for(const Kernel& kernel : kernels) {
+        bool opaque = !scalarOpaque;
+        auto run = [&]() {
+          return SkiaKernels::ConvertTgaPixelsWith(
+              kernel.instruction_set, source.data(), sourceBytes, count,
+              destRgba, dest.data(), &opaque);
+        };
+
+        if(!run()) {
+          continue;
+        }
+
+        EXPECT_EQ(0, memcmp(dest.data(), scalarDest.data(), dest.size()));
+        EXPECT_EQ(scalarOpaque, opaque);
+
+        if(IsBenchmarkEnabled()) {
+          double kernelNs = MeasureNsPerVertex(count, run);
+          printf("ConvertTgaPixels %d to %s: %-6s %6.3f ns/pixel (x%.1f)\n",
+                 sourceBytes * 8, destRgba ? "RGBA" : "BGRA", kernel.name,
+                 kernelNs, scalarNs / kernelNs);
+        }
+      }
+    }
+  }
+}
+
+// The loader LoadTexture() used before SkiaTextureLoader: the file is read to
+// a heap buffer and converted pixel by pixel.
+static bool LoadTgaLoop(const char* path, std::vector<Rml::byte>& pixels)
+{
+  FILE* file = fopen(path, "rb");
+  if(!file) {
+    return false;
+  }
+
+  std::vector<Rml::byte> buffer;
+  Rml::byte chunk[4096];
+  size_t readCnt;
+  while((readCnt = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    buffer.insert(buffer.end(), chunk, chunk + readCnt);
+  }
+  fclose(file);
+
+  if(buffer.size() <= 18 || buffer[2] != 2) {
+    return false;
+  }
+
+  const int width = buffer[12] | (buffer[13] << 8);
+  const int height = buffer[14] | (buffer[15] << 8);
+  const int colorMode = buffer[16] / 8;
+  const bool topOrigin = (buffer[17] & 32) != 0;
+  const Rml::byte* src = buffer.data() + 18;
+
+  pixels.resize(size_t(width) * height * 4);
+
+  for(long y = 0; y < height; ++y) {
+    long readIndex = y * width * colorMode;
+    long writeIndex = topOrigin ? y * width * 4 : (height - y - 1) * width * 4;
+
+    for(long x = 0; x < width; ++x) {
+      const Rml::byte alpha = colorMode == 4 ? src[readIndex + 3] : 255;
+      pixels[writeIndex] = Rml::byte((src[readIndex + 2] * alpha) / 255);
+      pixels[writeIndex + 1] = Rml::byte((src[readIndex + 1] * alpha) / 255);
+      pixels[writeIndex + 2] = Rml::byte((src[readIndex] * alpha) / 255);
+      pixels[writeIndex + 3] = alpha;
+
+      writeIndex += 4;
+      readIndex += colorMode;
+    }
+  }
+
+  return true;
+}
+
+// Compresses an uncompressed TGA to RLE, with packets running across rows.
+static std::vector<Rml::byte> EncodeTgaRle(const SkData& tga)
+{
+  const Rml::byte* data = tga.bytes();
+  const int pixelBytes = data[16] / 8;
+  const size_t pixelCount =
+      size_t(data[12] | (data[13] << 8)) * (data[14] | (data[15] << 8));
+  const Rml::byte* pixels = data + 18;
+
+  std::vector<Rml::byte> rle(data, data + 18);
+  rle[2] = 10;
+
+  auto samePixel = [&](size_t a, size_t b) {
+    return memcmp(pixels + a * pixelBytes, pixels + b * pixelBytes, pixelBytes)
+        == 0;
+  };
+
+  size_t i = 0;
+  while(i < pixelCount) {
+    size_t run = 1;
+    while(i + run < pixelCount && run < 128 && samePixel(i, i + run)) {
+      ++run;
+    }
+
+    if(run > 1) {
+      rle.push_back(Rml::byte(0x80 | (run - 1)));
+      rle.insert(
+          rle.end(), pixels + i * pixelBytes, pixels + (i + 1) * pixelBytes);
+    } else {
+      while(i + run < pixelCount && run < 128
+            && !samePixel(i + run - 1, i + run)) {
+        ++run;
+      }
+      rle.push_back(Rml::byte(run - 1));
+      rle.insert(
+          rle.end(), pixels + i * pixelBytes,
+          pixels + (i + run) * pixelBytes);
+    }
+    i += run;
+  }
+
+  return rle;
+}
+
+TEST(Benchmark, LoadTga)
+{
+  ASSERT_TRUE(SkiaBackend::Initialize("Load TGA Benchmark", 64, 64, true));
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  const int loadCount = 20;
+
+  for(const char* path :
+      {"assets/high_scores_alien_1.tga", "assets/high_scores_alien_2.tga",
+       "assets/high_scores_alien_3.tga", "assets/high_scores_defender.tga",
+       "assets/invader.tga"}) {
+    std::vector<Rml::byte> loopPixels;
+    ASSERT_TRUE(LoadTgaLoop(path, loopPixels));
+
+    auto load = [&]() {
+      SkBitmap bitmap;
+      bool opaque = false;
+      sk_sp<SkData> data = SkiaTextureLoader::LoadFile(path);
+      if(data) {
+        SkiaTextureLoader::DecodeTga(
+            data->data(), data->size(), SkColorType::kRGBA_8888_SkColorType,
+            bitmap, opaque);
+      }
+      return bitmap;
+    };
+
+    SkBitmap bitmap = load();
+    ASSERT_TRUE(bitmap.getPixels());
+    ASSERT_EQ(loopPixels.size(), bitmap.computeByteSize());
+    EXPECT_EQ(0, memcmp(bitmap.getPixels(), loopPixels.data(), loopPixels.size()));
+
+    if(IsBenchmarkEnabled()) {
+      double loopMs = MeasureMsPerFrame(
+          loadCount, [&]() { LoadTgaLoop(path, loopPixels); });
+      double loaderMs = MeasureMsPerFrame(loadCount, load);
+      printf("LoadTga %-32s: loop %6.3f ms, loader %6.3f ms (x%.1f)\n", path,
+             loopMs, loaderMs, loopMs / loaderMs);
+    }
+
+    // The RLE-compressed image decodes to the same pixels.
+    sk_sp<SkData> data = SkiaTextureLoader::LoadFile(path);
+    ASSERT_TRUE(data);
+    std::vector<Rml::byte> rle = EncodeTgaRle(*data);
+
+    SkBitmap rleBitmap;
+    bool opaque = false;
+    ASSERT_TRUE(SkiaTextureLoader::DecodeTga(
+        rle.data(), rle.size(), SkColorType::kRGBA_8888_SkColorType, rleBitmap,
+        opaque));
+    EXPECT_EQ(0, memcmp(rleBitmap.getPixels(), loopPixels.data(), loopPixels.size()));
+
+    // Truncated RLE data is rejected.
+    SkBitmap truncatedBitmap;
+    EXPECT_FALSE(SkiaTextureLoader::DecodeTga(
+        rle.data(), rle.size() - 1, SkColorType::kRGBA_8888_SkColorType,
+        truncatedBitmap, opaque));
+
+    // An image of more pixels than fit in int is rejected before allocation.
+    std::vector<Rml::byte> huge = rle;
+    std::fill(huge.begin() + 12, huge.begin() + 16, Rml::byte(0xFF));
+    SkBitmap hugeBitmap;
+    EXPECT_FALSE(SkiaTextureLoader::DecodeTga(
+        huge.data(), huge.size(), SkColorType::kRGBA_8888_SkColorType,
+        hugeBitmap, opaque));
+    EXPECT_EQ(hugeBitmap.getPixels(), nullptr);
+  }
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
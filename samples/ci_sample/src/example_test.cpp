@@ -30,12 +30,20 @@
 // #include "RmlUiSamples/FileBrowser.h"
 
 #include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
 #include "include/core/SkImage.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkStream.h"
 #include "include/core/SkSurface.h"
+#include "include/encode/SkJpegEncoder.h"
 
 #include "FileUtil.h"
 
+#include <atomic>
+#include <chrono>
 #include <stdio.h>
+#include <string.h>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -52,6 +60,7 @@ const char PATH_SEPARATOR = '/';
 #if __APPLE__
 #include <TargetConditionals.h>
 #include <string.h>
+#include <thread>
 
 #if TARGET_IPHONE_SIMULATOR
 // iOS Simulator
@@ -299,27 +308,971 @@ TEST(Example, test_RmlUi)
   rmlContext->Render();
   SkiaBackend::PresentFrame();
 
+  // Batching never issues more canvas draws than the submitted geometry.
+  const SkiaRenderInterface::FrameStats& frameStats =
+      skRmlRender->GetFrameStats();
+  EXPECT_GT(frameStats.geometry_draws, 0);
+  EXPECT_LE(frameStats.canvas_draws, frameStats.geometry_draws);
+  EXPECT_EQ(
+      frameStats.culled_geometry + frameStats.drawn_geometry,
+      frameStats.geometry_draws);
 
-  // Get picture from SkCanvas.
-  SkCanvas* skCanvas = skRmlRender->getCanvas();
-  SkImageInfo skImgInfo = skCanvas->imageInfo();
-  std::vector<unsigned char> frameBuf(skImgInfo.computeMinByteSize());
-
-  EXPECT_TRUE(skCanvas->readPixels(
-      skImgInfo, frameBuf.data(), skImgInfo.minRowBytes(), 0, 0));
+  // The scratch memory of a steady-state frame fits in the frame arena.
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+  EXPECT_EQ(frameStats.arena_block_allocations, 0);
+  // The vertices built and merged by the first frame are drawn as they are.
+  EXPECT_EQ(frameStats.vertex_builds, 0);
+
+  // The scissor clips are restored at the end of the frame.
+  EXPECT_EQ(skRmlRender->getCanvas()->getSaveCount(), 1);
+
+
+  // Get picture from the surface, without copying.
+  SkImageInfo skImgInfo = skRmlRender->getCanvas()->imageInfo();
+  Rml::Span<const Rml::byte> framePixels = SkiaBackend::GetPixels();
+  ASSERT_EQ(framePixels.size(), skImgInfo.computeMinByteSize());
+  ASSERT_EQ(SkiaBackend::GetRowBytes(), skImgInfo.minRowBytes());
+
+  // The surface is rendered in the native colour type, the picture is
+  // converted to RGBA once on export.
+  EXPECT_EQ(SkiaBackend::GetColorType(), kN32_SkColorType);
+  EXPECT_EQ(skRmlRender->GetTextureColorType(), kN32_SkColorType);
+  SkImageInfo exportInfo =
+      skImgInfo.makeColorType(SkColorType::kRGBA_8888_SkColorType);
+  std::vector<unsigned char> exportBuf(exportInfo.computeMinByteSize());
+  ASSERT_TRUE(skRmlRender->getCanvas()->readPixels(
+      exportInfo, exportBuf.data(), exportInfo.minRowBytes(), 0, 0));
 
   // Write picture to file.
   writePpmFile(
-      frameBuf.data(), skImgInfo.width(), skImgInfo.height(),
-      skImgInfo.bytesPerPixel(), fileOutTest1);
+      exportBuf.data(), exportInfo.width(), exportInfo.height(),
+      exportInfo.bytesPerPixel(), fileOutTest1);
+
+  // The frame to compare the next frames with.
+  std::vector<unsigned char> frameBuf(framePixels.begin(), framePixels.end());
+  auto isSameFrame = [&frameBuf]() {
+    Rml::Span<const Rml::byte> pixels = SkiaBackend::GetPixels();
+    return pixels.size() == frameBuf.size()
+        && memcmp(pixels.data(), frameBuf.data(), frameBuf.size()) == 0;
+  };
 
-  // Compare our file with prototype.
+  // Compare our file with prototype. The translucent rows of the tree were
+  // rendered with their colour premultiplied twice, and were corrected in
+  // the prototype afterwards: their pixels may be one off where the blending
+  // rounds the other way, and up to two off at the edges of the glyphs and
+  // icons drawn over them. After a deliberate change of the rendering
+  // RmlUi_draw.ppm, written above, replaces the prototype.
   std::string fileTest1 =
       resourceDir + "data" + PATH_SEPARATOR + "RmlUi_draw_test_sample.ppm";
-  EXPECT_TRUE(compareFiles(fileTest1, fileOutTest1));
+  int maxDifference = 0;
+  size_t differentPixels = 0;
+  EXPECT_TRUE(comparePpmFiles(
+      fileTest1, fileOutTest1, 1, maxDifference, differentPixels));
+  EXPECT_LE(maxDifference, 2);
+  EXPECT_LE(differentPixels, 1000u);
+
+
+  // An unchanged frame is replayed from the cached picture, with the same
+  // pixels.
+  skRmlRender->SetPictureCacheEnabled(true);
+  for(int i = 0; i < 2; ++i) {
+    SkiaBackend::BeginFrame();
+    rmlContext->Render();
+    SkiaBackend::PresentFrame();
+  }
+
+  const SkiaRenderInterface::PictureCacheStats& cacheStats =
+      skRmlRender->GetPictureCacheStats();
+  EXPECT_EQ(cacheStats.misses, 1);
+  EXPECT_EQ(cacheStats.hits, 1);
+
+  EXPECT_TRUE(isSameFrame());
+
+  // Releasing a geometry which the cached picture does not draw keeps it.
+  const Rml::Vertex unusedVertices[3] = {};
+  const int unusedIndices[3] = {0, 1, 2};
+  skRmlRender->ReleaseGeometry(skRmlRender->CompileGeometry(
+      {unusedVertices, 3}, {unusedIndices, 3}));
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+  EXPECT_EQ(cacheStats.invalidations, 0);
+  EXPECT_EQ(cacheStats.hits, 2);
+
+  // A geometry released during an unchanged frame plays the frame into a
+  // recording, which the cached picture replaces.
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  skRmlRender->ReleaseGeometry(skRmlRender->CompileGeometry(
+      {unusedVertices, 3}, {unusedIndices, 3}));
+  SkiaBackend::PresentFrame();
+  EXPECT_EQ(cacheStats.hits, 3);
+  EXPECT_TRUE(isSameFrame());
+
+  // The next frames draw their own commands only: an empty frame leaves the
+  // background where the document was.
+  SkiaBackend::BeginFrame();
+  SkiaBackend::PresentFrame();
+  EXPECT_EQ(cacheStats.misses, 2);
+  SkPixmap framePixmap;
+  ASSERT_TRUE(skRmlRender->getCanvas()->peekPixels(&framePixmap));
+  EXPECT_EQ(framePixmap.getColor(300, 190), SK_ColorBLACK);
+
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+  EXPECT_EQ(cacheStats.misses, 3);
+  EXPECT_TRUE(isSameFrame());
+  skRmlRender->SetPictureCacheEnabled(false);
+
+  // With damage tracking the first frame is drawn in full, and an unchanged
+  // frame draws nothing.
+  skRmlRender->SetDamageTrackingEnabled(true);
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  EXPECT_EQ(SkiaBackend::PresentFrame().size(), 1u);
+
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  EXPECT_TRUE(SkiaBackend::PresentFrame().empty());
+
+  EXPECT_TRUE(isSameFrame());
+  skRmlRender->SetDamageTrackingEnabled(false);
+
+  // Tiles played back on several threads give the same pixels, and do not
+  // write to the pixels of a snapshot of the surface. The snapshot is taken
+  // of a surface cleared to another colour than the background.
+  SkSurface* frameSurface = skRmlRender->getCanvas()->getSurface();
+  ASSERT_NE(frameSurface, nullptr);
+  frameSurface->getCanvas()->clear(SK_ColorMAGENTA);
+  sk_sp<SkImage> snapshot = frameSurface->makeImageSnapshot();
+  skRmlRender->SetRasterThreadCount(4);
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+
+  EXPECT_TRUE(isSameFrame());
+  SkPixmap snapshotPixmap;
+  ASSERT_TRUE(snapshot->peekPixels(&snapshotPixmap));
+  EXPECT_EQ(snapshotPixmap.getColor(0, 0), SK_ColorMAGENTA);
+  // A pixel covered by the document.
+  EXPECT_EQ(snapshotPixmap.getColor(300, 190), SK_ColorMAGENTA);
+  skRmlRender->SetRasterThreadCount(1);
 
 
   // Shutdown RmlUi.
   Rml::Shutdown();
   SkiaBackend::Shutdown();
 }
+
+
+TEST(Example, test_RmlUi_direct)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  // Rows padded past the frame width, as framebuffer mappings often are.
+  const size_t rowBytes = frameWidth * 4 + 64;
+  const unsigned char padding = 0xA5;
+  std::vector<unsigned char> pixels(frameHeight * rowBytes, padding);
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Direct Sample", frameWidth, frameHeight, pixels.data(), rowBytes));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::Context* rmlContext =
+      Rml::CreateContext("main", Rml::Vector2i(frameWidth, frameHeight));
+  ASSERT_TRUE(rmlContext);
+
+  LoadFonts("");
+  Rml::ElementDocument* document = rmlContext->LoadDocument("assets/demo.rml");
+  ASSERT_TRUE(document);
+  document->Show();
+
+  rmlContext->Update();
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+
+  // The frame is rendered straight into our memory.
+  EXPECT_EQ(SkiaBackend::GetPixels().data(), pixels.data());
+  EXPECT_EQ(SkiaBackend::GetRowBytes(), rowBytes);
+
+  bool paddingKept = true;
+  bool frameDrawn = false;
+  for(int y = 0; y < frameHeight; ++y) {
+    const unsigned char* row = pixels.data() + y * rowBytes;
+    for(size_t x = frameWidth * 4; x < rowBytes; ++x) {
+      paddingKept = paddingKept && row[x] == padding;
+    }
+    for(int x = 0; x < frameWidth * 4; x += 4) {
+      // Anything but the black background.
+      frameDrawn =
+          frameDrawn || row[x] != 0 || row[x + 1] != 0 || row[x + 2] != 0;
+    }
+  }
+  EXPECT_TRUE(paddingKept);
+  EXPECT_TRUE(frameDrawn);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+
+TEST(Example, test_RmlUi_low_bit_depth)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Low Bit Depth Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  LoadFonts("");
+
+  for(SkColorType colorType : {kRGB_565_SkColorType, kGray_8_SkColorType}) {
+    Rml::UniquePtr<SkiaBackend::Instance> instance =
+        SkiaBackend::Instance::Create(frameWidth, frameHeight, colorType);
+    ASSERT_TRUE(instance);
+
+    SkiaRenderInterface* renderInterface = instance->GetRenderInterface();
+    EXPECT_EQ(renderInterface->GetTextureColorType(), kN32_SkColorType);
+    EXPECT_EQ(renderInterface->GetOpaqueTextureColorType(), colorType);
+    renderInterface->SetDitheringEnabled(true);
+
+    Rml::Context* rmlContext = Rml::CreateContext(
+        "low_bit_depth", Rml::Vector2i(frameWidth, frameHeight),
+        renderInterface);
+    ASSERT_TRUE(rmlContext);
+
+    Rml::ElementDocument* document =
+        rmlContext->LoadDocument("assets/demo.rml");
+    ASSERT_TRUE(document);
+    document->Show();
+
+    rmlContext->Update();
+    instance->BeginFrame();
+    rmlContext->Render();
+    instance->PresentFrame();
+
+    // The surface takes 2 or 1 bytes per pixel.
+    const SkImageInfo info = instance->GetCanvas()->imageInfo();
+    Rml::Span<const Rml::byte> pixels = instance->GetPixels();
+    EXPECT_EQ(pixels.size(), size_t(frameHeight) * instance->GetRowBytes());
+    EXPECT_EQ(info.bytesPerPixel(), colorType == kGray_8_SkColorType ? 1 : 2);
+
+    // Anything but the black background.
+    bool frameDrawn = false;
+    for(Rml::byte pixel : pixels) {
+      frameDrawn = frameDrawn || pixel != 0;
+    }
+    EXPECT_TRUE(frameDrawn);
+
+    Rml::RemoveContext("low_bit_depth");
+    Rml::ReleaseRenderManagers();
+  }
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+
+TEST(Example, test_RmlUi_present_thread)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+  const int frameCount = 8;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Present Thread Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::Context* rmlContext =
+      Rml::CreateContext("main", Rml::Vector2i(frameWidth, frameHeight));
+  ASSERT_TRUE(rmlContext);
+
+  LoadFonts("");
+  Rml::ElementDocument* document = rmlContext->LoadDocument("assets/demo.rml");
+  ASSERT_TRUE(document);
+  document->Show();
+  rmlContext->Update();
+
+  // The frame rendered on this thread, to compare the presented ones with.
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+
+  Rml::Span<const Rml::byte> framePixels = SkiaBackend::GetPixels();
+  const std::vector<unsigned char> frameBuf(
+      framePixels.begin(), framePixels.end());
+  const size_t frameRowBytes = SkiaBackend::GetRowBytes();
+
+  SkiaBackend::Instance* instance = SkiaBackend::GetInstance();
+  const uint64_t firstFrame = instance->GetFinishedFrame() + 1;
+
+  // Written by the present thread only, read after it stopped.
+  std::vector<uint64_t> presentedFrames;
+  int samePixels = 0;
+
+  ASSERT_TRUE(SkiaBackend::StartPresentThread(
+      3, [&](const SkiaBackend::Frame& frame) {
+        presentedFrames.push_back(frame.index);
+        if(frame.row_bytes == frameRowBytes
+           && frame.pixels.size() == frameBuf.size()
+           && memcmp(frame.pixels.data(), frameBuf.data(), frameBuf.size())
+               == 0) {
+          ++samePixels;
+        }
+      }));
+
+  for(int i = 0; i < frameCount; ++i) {
+    SkiaBackend::BeginFrame();
+    rmlContext->Render();
+    SkiaBackend::PresentFrame();
+
+    // Never more frames in flight than the buffers besides the one rendered
+    // to.
+    EXPECT_LE(
+        instance->GetFinishedFrame() - instance->GetPresentedFrame(), 2u);
+  }
+
+  const uint64_t lastFrame = instance->GetFinishedFrame();
+  instance->WaitForFrame(lastFrame);
+  EXPECT_EQ(instance->GetPresentedFrame(), lastFrame);
+
+  SkiaBackend::StopPresentThread();
+
+  ASSERT_EQ(presentedFrames.size(), size_t(frameCount));
+  for(int i = 0; i < frameCount; ++i) {
+    EXPECT_EQ(presentedFrames[i], firstFrame + i);
+  }
+  EXPECT_EQ(samePixels, frameCount);
+
+  // Rendering goes on into one surface, which holds the last frame.
+  EXPECT_TRUE(
+      memcmp(SkiaBackend::GetPixels().data(), frameBuf.data(), frameBuf.size())
+      == 0);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+
+TEST(Example, test_RmlUi_resize)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Resize Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::Context* rmlContext =
+      Rml::CreateContext("main", Rml::Vector2i(frameWidth, frameHeight));
+  ASSERT_TRUE(rmlContext);
+
+  LoadFonts("");
+  Rml::ElementDocument* document = rmlContext->LoadDocument("assets/demo.rml");
+  ASSERT_TRUE(document);
+  document->Show();
+
+  // Renders a frame of the given size, returns false if nothing was drawn.
+  auto renderFrame = [&](int width, int height) {
+    rmlContext->SetDimensions({width, height});
+    rmlContext->Update();
+    SkiaBackend::BeginFrame();
+    rmlContext->Render();
+    SkiaBackend::PresentFrame();
+
+    Rml::Span<const Rml::byte> pixels = SkiaBackend::GetPixels();
+    EXPECT_EQ(pixels.size(), size_t(height) * SkiaBackend::GetRowBytes());
+
+    bool frameDrawn = false;
+    for(Rml::byte pixel : pixels) {
+      frameDrawn = frameDrawn || pixel != 0;
+    }
+    return frameDrawn;
+  };
+
+  EXPECT_TRUE(renderFrame(frameWidth, frameHeight));
+  const Rml::byte* initialPixels = SkiaBackend::GetPixels().data();
+
+  // A smaller surface reuses the memory.
+  ASSERT_TRUE(SkiaBackend::Resize(200, 150));
+  EXPECT_EQ(SkiaBackend::GetPixels().data(), initialPixels);
+  EXPECT_EQ(SkiaBackend::GetRowBytes(), 200u * 4);
+  EXPECT_TRUE(renderFrame(200, 150));
+
+  // A larger one grows it, the fonts and textures are kept.
+  ASSERT_TRUE(SkiaBackend::Resize(400, 300));
+  const Rml::byte* grownPixels = SkiaBackend::GetPixels().data();
+  EXPECT_EQ(SkiaBackend::GetRowBytes(), 400u * 4);
+  EXPECT_TRUE(renderFrame(400, 300));
+
+  // Back to the first size, within the grown memory.
+  ASSERT_TRUE(SkiaBackend::Resize(frameWidth, frameHeight));
+  EXPECT_EQ(SkiaBackend::GetPixels().data(), grownPixels);
+  EXPECT_TRUE(renderFrame(frameWidth, frameHeight));
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+
+  // Without allow_resize the surface keeps its size.
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Fixed Size Sample", frameWidth, frameHeight, false));
+  EXPECT_FALSE(SkiaBackend::Resize(400, 300));
+  EXPECT_EQ(SkiaBackend::GetRowBytes(), size_t(frameWidth) * 4);
+  SkiaBackend::Shutdown();
+}
+
+
+// Event source of the frame loop test, events are queued by the test.
+class TestEventSource : public SkiaBackend::EventSource
+{
+public:
+  bool WaitForEvents(double timeout) override
+  {
+    last_timeout = timeout;
+    return pending_events > 0;
+  }
+
+  void Wake() override
+  {
+    ++wakes;
+  }
+
+  bool ProcessEvents(Rml::Context* context) override
+  {
+    for(; pending_events > 0; --pending_events) {
+      context->ProcessMouseMove(10, 10, 0);
+    }
+    return true;
+  }
+
+  int pending_events = 0;
+  double last_timeout = -1;
+  int wakes = 0;
+};
+
+// System interface of the frame loop test, its clock is set by the test.
+class TestClockSystemInterface : public Rml::SystemInterface
+{
+public:
+  double GetElapsedTime() override
+  {
+    return time;
+  }
+
+  double time = 0;
+};
+
+TEST(Example, test_RmlUi_frame_schedule)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Frame Schedule Sample", frameWidth, frameHeight, true));
+
+  TestClockSystemInterface testClock;
+  Rml::SetSystemInterface(&testClock);
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  Rml::Context* rmlContext =
+      Rml::CreateContext("main", Rml::Vector2i(frameWidth, frameHeight));
+  ASSERT_TRUE(rmlContext);
+
+  LoadFonts("");
+  Rml::ElementDocument* document = rmlContext->LoadDocumentFromMemory(
+      "<rml><head><style>body { font-family: LatoLatin; color: white; }"
+      "</style></head><body>Idle dashboard</body></rml>");
+  ASSERT_TRUE(document);
+  document->Show();
+
+  TestEventSource eventSource;
+  SkiaBackend::SetEventSource(&eventSource);
+  const SkiaBackend::ScheduleStats& stats = SkiaBackend::GetScheduleStats();
+
+  // The first frame renders, then the static document goes idle.
+  for(int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  }
+  EXPECT_GE(stats.rendered_frames, 1u);
+  EXPECT_GT(stats.skipped_frames, 0u);
+  EXPECT_EQ(stats.rendered_frames + stats.skipped_frames, 10u);
+
+  // An idle frame waits for events instead of spinning.
+  uint64_t skippedFrames = stats.skipped_frames;
+  uint64_t renderedFrames = stats.rendered_frames;
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_EQ(stats.skipped_frames, skippedFrames + 1);
+  EXPECT_GT(eventSource.last_timeout, 0.0);
+
+  // Events and requested frames render.
+  eventSource.pending_events = 1;
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_EQ(eventSource.pending_events, 0);
+  EXPECT_EQ(stats.rendered_frames, renderedFrames + 1);
+
+  // A requested frame wakes the event source from its wait.
+  SkiaBackend::RequestFrame();
+  EXPECT_EQ(eventSource.wakes, 1);
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_EQ(stats.rendered_frames, renderedFrames + 2);
+
+  // Without power save every frame renders, without waiting.
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext, false));
+  EXPECT_EQ(stats.rendered_frames, renderedFrames + 3);
+  EXPECT_EQ(eventSource.last_timeout, 0.0);
+
+  // A delay longer than the longest wait counts from the update which
+  // requested it, over several waits.
+  testClock.time = 100.0;
+  SkiaBackend::RequestFrame();
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_EQ(stats.rendered_frames, renderedFrames + 4);
+  rmlContext->RequestNextUpdate(15.0);
+
+  testClock.time = 104.0;
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_DOUBLE_EQ(eventSource.last_timeout, 10.0);
+  testClock.time = 112.0;
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_DOUBLE_EQ(eventSource.last_timeout, 3.0);
+  EXPECT_EQ(stats.rendered_frames, renderedFrames + 4);
+
+  testClock.time = 115.0;
+  EXPECT_TRUE(SkiaBackend::ProcessFrame(rmlContext));
+  EXPECT_EQ(stats.rendered_frames, renderedFrames + 5);
+
+  SkiaBackend::RequestExit();
+  EXPECT_FALSE(SkiaBackend::ProcessFrame(rmlContext));
+
+  SkiaBackend::SetEventSource(nullptr);
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+
+// Compiles a quad showing the whole texture at the given rectangle.
+static Rml::CompiledGeometryHandle CompileTextureQuad(
+    Rml::RenderInterface* renderInterface, float width, float height)
+{
+  const Rml::ColourbPremultiplied white(255, 255, 255, 255);
+  const Rml::Vertex vertices[] = {
+      {{0, 0}, white, {0, 0}},
+      {{width, 0}, white, {1, 0}},
+      {{width, height}, white, {1, 1}},
+      {{0, height}, white, {0, 1}},
+  };
+  const int indices[] = {0, 1, 2, 0, 2, 3};
+
+  return renderInterface->CompileGeometry({vertices, 4}, {indices, 6});
+}
+
+// Returns true if any pixel of the rectangle differs from the black
+// background.
+static bool IsRectDrawn(int left, int top, int width, int height)
+{
+  Rml::Span<const Rml::byte> pixels = SkiaBackend::GetPixels();
+  const size_t rowBytes = SkiaBackend::GetRowBytes();
+
+  for(int y = top; y < top + height; ++y) {
+    for(int x = left * 4; x < (left + width) * 4; x += 4) {
+      const Rml::byte* pixel = pixels.data() + y * rowBytes + x;
+      if(pixel[0] != 0 || pixel[1] != 0 || pixel[2] != 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+TEST(Example, test_RmlUi_encoded_images)
+{
+  const int frameWidth = 640;
+  const int frameHeight = 480;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Encoded Images Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  auto* renderInterface =
+      static_cast<SkiaRenderInterface*>(SkiaBackend::GetRenderInterface());
+  const SkiaRenderInterface::TextureStats& stats =
+      renderInterface->GetTextureStats();
+
+  // A JPEG copy of the PNG asset, JPEG decodes at reduced sizes.
+  sk_sp<SkImage> pngImage = SkImage::MakeFromEncoded(
+      SkData::MakeFromFileName("assets/hello_world.png"));
+  ASSERT_TRUE(pngImage);
+  pngImage = pngImage->makeRasterImage();
+  SkPixmap pngPixmap;
+  ASSERT_TRUE(pngImage && pngImage->peekPixels(&pngPixmap));
+  {
+    SkFILEWStream jpegFile("RmlUi_hello_world.jpg");
+    ASSERT_TRUE(jpegFile.isValid());
+    ASSERT_TRUE(SkJpegEncoder::Encode(&jpegFile, pngPixmap, {}));
+  }
+
+  Rml::Vector2i pngSize;
+  Rml::TextureHandle pngTexture =
+      renderInterface->LoadTexture(pngSize, "assets/hello_world.png");
+  Rml::Vector2i jpegSize;
+  Rml::TextureHandle jpegTexture =
+      renderInterface->LoadTexture(jpegSize, "RmlUi_hello_world.jpg");
+  ASSERT_TRUE(pngTexture);
+  ASSERT_TRUE(jpegTexture);
+
+  // The headers give the sizes, nothing is decoded yet.
+  EXPECT_EQ(pngSize, Rml::Vector2i(540, 276));
+  EXPECT_EQ(jpegSize, Rml::Vector2i(540, 276));
+  EXPECT_EQ(stats.encoded_textures, 2);
+  EXPECT_EQ(stats.scaled_decodes, 0);
+
+  // Drawn at a quarter of their size, the JPEG decodes at that size, the PNG
+  // codec can not scale.
+  Rml::CompiledGeometryHandle smallQuad =
+      CompileTextureQuad(renderInterface, 135, 69);
+  SkiaBackend::BeginFrame();
+  renderInterface->RenderGeometry(smallQuad, {0, 0}, pngTexture);
+  renderInterface->RenderGeometry(smallQuad, {200, 0}, jpegTexture);
+  SkiaBackend::PresentFrame();
+
+  EXPECT_EQ(stats.scaled_decodes, 1);
+  EXPECT_TRUE(IsRectDrawn(0, 0, 135, 69));
+  EXPECT_TRUE(IsRectDrawn(200, 0, 135, 69));
+
+  // Drawn at the full size, the JPEG is decoded again in full.
+  Rml::CompiledGeometryHandle fullQuad =
+      CompileTextureQuad(renderInterface, 540, 276);
+  SkiaBackend::BeginFrame();
+  renderInterface->RenderGeometry(fullQuad, {0, 100}, jpegTexture);
+  SkiaBackend::PresentFrame();
+
+  EXPECT_EQ(stats.scaled_decodes, 1);
+  EXPECT_TRUE(IsRectDrawn(0, 100, 540, 276));
+
+  // The corners of the texture at their full size, like the corners of a
+  // 9-slice. The geometry is half as large as the texture, but its quads draw
+  // at the full scale, so the JPEG is decoded in full.
+  Rml::TextureHandle sliceTexture =
+      renderInterface->LoadTexture(jpegSize, "RmlUi_hello_world.jpg");
+  ASSERT_TRUE(sliceTexture);
+  const Rml::ColourbPremultiplied white(255, 255, 255, 255);
+  std::vector<Rml::Vertex> sliceVertices;
+  std::vector<int> sliceIndices;
+  for(int corner = 0; corner < 4; ++corner) {
+    const float x = corner % 2 * 135.f;
+    const float y = corner / 2 * 69.f;
+    const float u = corner % 2 * 0.75f;
+    const float v = corner / 2 * 0.75f;
+    const int first = static_cast<int>(sliceVertices.size());
+    sliceVertices.push_back({{x, y}, white, {u, v}});
+    sliceVertices.push_back({{x + 135, y}, white, {u + 0.25f, v}});
+    sliceVertices.push_back({{x + 135, y + 69}, white, {u + 0.25f, v + 0.25f}});
+    sliceVertices.push_back({{x, y + 69}, white, {u, v + 0.25f}});
+    for(int index : {0, 1, 2, 0, 2, 3}) {
+      sliceIndices.push_back(first + index);
+    }
+  }
+  Rml::CompiledGeometryHandle sliceGeometry = renderInterface->CompileGeometry(
+      {sliceVertices.data(), sliceVertices.size()},
+      {sliceIndices.data(), sliceIndices.size()});
+  SkiaBackend::BeginFrame();
+  renderInterface->RenderGeometry(sliceGeometry, {0, 100}, sliceTexture);
+  SkiaBackend::PresentFrame();
+
+  EXPECT_EQ(stats.scaled_decodes, 1);
+  EXPECT_TRUE(IsRectDrawn(0, 100, 270, 138));
+
+  renderInterface->ReleaseGeometry(smallQuad);
+  renderInterface->ReleaseGeometry(fullQuad);
+  renderInterface->ReleaseGeometry(sliceGeometry);
+  renderInterface->ReleaseTexture(pngTexture);
+  renderInterface->ReleaseTexture(jpegTexture);
+  renderInterface->ReleaseTexture(sliceTexture);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+TEST(Example, test_RmlUi_async_textures)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Async Textures Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  auto* renderInterface =
+      static_cast<SkiaRenderInterface*>(SkiaBackend::GetRenderInterface());
+  const SkiaRenderInterface::TextureStats& stats =
+      renderInterface->GetTextureStats();
+
+  std::atomic<int> loadedCount {0};
+  renderInterface->SetTextureLoadThreadCount(2);
+  renderInterface->SetTextureLoadedCallback([&](Rml::TextureHandle) {
+    ++loadedCount;
+    SkiaBackend::RequestFrame();
+  });
+
+  // The handles are returned at once, the size of a source is not known
+  // before it was loaded.
+  Rml::Vector2i size;
+  Rml::TextureHandle texture =
+      renderInterface->LoadTexture(size, "assets/invader.tga");
+  ASSERT_TRUE(texture);
+  EXPECT_EQ(size, Rml::Vector2i(0, 0));
+
+  Rml::Vector2i releasedSize;
+  Rml::TextureHandle releasedTexture =
+      renderInterface->LoadTexture(releasedSize, "assets/present.tga");
+  ASSERT_TRUE(releasedTexture);
+  renderInterface->ReleaseTexture(releasedTexture);
+
+  for(int i = 0; i < 1000 && loadedCount < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(loadedCount, 2);
+  EXPECT_EQ(stats.async_loads, 0);
+
+  // The next frame swaps in the loaded texture, the released one is dropped.
+  Rml::CompiledGeometryHandle quad =
+      CompileTextureQuad(renderInterface, 128, 128);
+  SkiaBackend::BeginFrame();
+  renderInterface->RenderGeometry(quad, {0, 0}, texture);
+  SkiaBackend::PresentFrame();
+
+  EXPECT_EQ(stats.async_loads, 1);
+  EXPECT_TRUE(IsRectDrawn(0, 0, 128, 128));
+
+  // Loaded once, the size is known.
+  Rml::Vector2i knownSize;
+  Rml::TextureHandle knownTexture =
+      renderInterface->LoadTexture(knownSize, "assets/invader.tga");
+  EXPECT_EQ(knownSize, Rml::Vector2i(512, 512));
+
+  // Without loader threads the queued loads finish and are swapped in.
+  renderInterface->SetTextureLoadThreadCount(0);
+  EXPECT_EQ(loadedCount, 3);
+  SkiaBackend::BeginFrame();
+  SkiaBackend::PresentFrame();
+  EXPECT_EQ(stats.async_loads, 2);
+
+  renderInterface->SetTextureLoadedCallback(nullptr);
+  renderInterface->ReleaseGeometry(quad);
+  renderInterface->ReleaseTexture(texture);
+  renderInterface->ReleaseTexture(knownTexture);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+TEST(Example, test_RmlUi_texture_cache)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Texture Cache Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  auto* renderInterface =
+      static_cast<SkiaRenderInterface*>(SkiaBackend::GetRenderInterface());
+  const SkiaRenderInterface::TextureStats& stats =
+      renderInterface->GetTextureStats();
+  const size_t residentBytes = stats.resident_bytes;
+
+  Rml::Vector2i invaderSize;
+  Rml::TextureHandle invader =
+      renderInterface->LoadTexture(invaderSize, "assets/invader.tga");
+  Rml::Vector2i presentSize;
+  Rml::TextureHandle present =
+      renderInterface->LoadTexture(presentSize, "assets/present.tga");
+  ASSERT_TRUE(invader);
+  ASSERT_TRUE(present);
+
+  const size_t invaderBytes = size_t(invaderSize.x) * invaderSize.y * 4;
+  const size_t presentBytes = size_t(presentSize.x) * presentSize.y * 4;
+  EXPECT_EQ(stats.resident_bytes, residentBytes + invaderBytes + presentBytes);
+
+  // Room for the invader atlas only.
+  const size_t budget = residentBytes + invaderBytes;
+  renderInterface->SetTextureBudget(budget);
+
+  Rml::CompiledGeometryHandle quad =
+      CompileTextureQuad(renderInterface, 128, 128);
+
+  auto drawFrame = [&](Rml::TextureHandle texture) {
+    SkiaBackend::BeginFrame();
+    renderInterface->RenderGeometry(quad, {0, 0}, texture);
+    SkiaBackend::PresentFrame();
+  };
+
+  // The texture not drawn is evicted.
+  drawFrame(invader);
+  EXPECT_EQ(stats.cache_hits, 1u);
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_LE(stats.resident_bytes, budget);
+  EXPECT_TRUE(IsRectDrawn(0, 0, 128, 128));
+
+  // Drawing an evicted texture loads it again, the least recently drawn one
+  // makes room for it.
+  drawFrame(present);
+  EXPECT_EQ(stats.cache_misses, 1u);
+  EXPECT_EQ(stats.evictions, 2);
+  EXPECT_LE(stats.resident_bytes, budget);
+  EXPECT_TRUE(IsRectDrawn(0, 0, 128, 128));
+
+  drawFrame(invader);
+  EXPECT_EQ(stats.cache_misses, 2u);
+  EXPECT_EQ(stats.evictions, 3);
+  EXPECT_EQ(stats.resident_bytes, residentBytes + invaderBytes);
+  EXPECT_TRUE(IsRectDrawn(0, 0, 128, 128));
+
+  drawFrame(invader);
+  EXPECT_EQ(stats.cache_hits, 2u);
+  EXPECT_DOUBLE_EQ(stats.GetCacheHitRate(), 0.5);
+
+  // Without a budget nothing is evicted.
+  renderInterface->SetTextureBudget(0);
+  drawFrame(present);
+  drawFrame(invader);
+  EXPECT_EQ(stats.evictions, 3);
+  EXPECT_EQ(stats.resident_bytes, residentBytes + invaderBytes + presentBytes);
+
+  renderInterface->ReleaseGeometry(quad);
+  renderInterface->ReleaseTexture(invader);
+  renderInterface->ReleaseTexture(present);
+  EXPECT_EQ(stats.resident_bytes, residentBytes);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}
+
+TEST(Example, test_RmlUi_generated_textures)
+{
+  const int frameWidth = 320;
+  const int frameHeight = 240;
+
+  ASSERT_TRUE(SkiaBackend::Initialize(
+      "Generated Textures Sample", frameWidth, frameHeight, true));
+
+  Rml::SetSystemInterface(SkiaBackend::GetSystemInterface());
+  Rml::SetFontEngineInterface(SkiaBackend::GetFontEngineInterface());
+  Rml::SetRenderInterface(SkiaBackend::GetRenderInterface());
+  ASSERT_TRUE(Rml::Initialise());
+
+  auto* renderInterface =
+      static_cast<SkiaRenderInterface*>(SkiaBackend::GetRenderInterface());
+  const SkiaRenderInterface::TextureStats& stats =
+      renderInterface->GetTextureStats();
+
+  Rml::Context* rmlContext =
+      Rml::CreateContext("main", Rml::Vector2i(frameWidth, frameHeight));
+  ASSERT_TRUE(rmlContext);
+
+  LoadFonts("");
+  Rml::ElementDocument* document = rmlContext->LoadDocument("assets/demo.rml");
+  ASSERT_TRUE(document);
+  document->Show();
+
+  rmlContext->Update();
+  SkiaBackend::BeginFrame();
+  rmlContext->Render();
+  SkiaBackend::PresentFrame();
+
+  // The font engine writes its glyph atlases into the texture pixels.
+  EXPECT_GT(stats.adopted_textures, 0);
+  EXPECT_EQ(stats.copied_textures, 0);
+
+  // Pixels in memory of the texture memory and pixels copied from other
+  // memory give the same texture.
+  const Rml::Vector2i size(4, 4);
+  std::vector<Rml::byte> pixels(size.x * size.y * 4);
+  for(size_t i = 0; i < pixels.size(); i += 4) {
+    pixels[i] = 200;
+    pixels[i + 1] = 100;
+    pixels[i + 2] = 50;
+    pixels[i + 3] = 255;
+  }
+  SkiaTextureMemory* textureMemory = renderInterface->GetTextureMemory();
+  ASSERT_TRUE(textureMemory);
+  Rml::Span<Rml::byte> allocated = textureMemory->AllocateTexture(size);
+  ASSERT_EQ(allocated.size(), pixels.size());
+  memcpy(allocated.data(), pixels.data(), pixels.size());
+
+  const int adoptedTextures = stats.adopted_textures;
+  const int copiedTextures = stats.copied_textures;
+  Rml::TextureHandle adopted = renderInterface->GenerateTexture(
+      Rml::Span<const Rml::byte>(allocated.data(), allocated.size()), size);
+  Rml::TextureHandle copied = renderInterface->GenerateTexture(
+      Rml::Span<const Rml::byte>(pixels.data(), pixels.size()), size);
+  ASSERT_TRUE(adopted);
+  ASSERT_TRUE(copied);
+  EXPECT_EQ(stats.adopted_textures, adoptedTextures + 1);
+  EXPECT_EQ(stats.copied_textures, copiedTextures + 1);
+
+  // The memory is taken once, releasing it afterwards does nothing.
+  EXPECT_FALSE(textureMemory->TakeTexture(
+      Rml::Span<const Rml::byte>(allocated.data(), allocated.size())));
+  textureMemory->ReleaseTexture(allocated);
+
+  Rml::CompiledGeometryHandle quad =
+      CompileTextureQuad(renderInterface, 16, 16);
+  SkiaBackend::BeginFrame();
+  renderInterface->RenderGeometry(quad, {0, 0}, adopted);
+  renderInterface->RenderGeometry(quad, {32, 0}, copied);
+  SkiaBackend::PresentFrame();
+
+  EXPECT_TRUE(IsRectDrawn(0, 0, 16, 16));
+  Rml::Span<const Rml::byte> frame = SkiaBackend::GetPixels();
+  const size_t rowBytes = SkiaBackend::GetRowBytes();
+  bool sameTextures = true;
+  for(int y = 0; y < 16; ++y) {
+    const Rml::byte* row = frame.data() + y * rowBytes;
+    sameTextures = sameTextures && memcmp(row, row + 32 * 4, 16 * 4) == 0;
+  }
+  EXPECT_TRUE(sameTextures);
+
+  renderInterface->ReleaseGeometry(quad);
+  renderInterface->ReleaseTexture(adopted);
+  renderInterface->ReleaseTexture(copied);
+
+  Rml::Shutdown();
+  SkiaBackend::Shutdown();
+}